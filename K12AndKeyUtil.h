@@ -2,6 +2,8 @@
 #include <immintrin.h>
 #include <cstdint>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #define ROL64(a, offset) ((((unsigned long long)a) << offset) ^ (((unsigned long long)a) >> (64 - offset)))
 
@@ -1806,8 +1808,9 @@ static void wNAF_recode(unsigned long long scalar, unsigned int w, char* digits)
     memset(&digits[index], 0, 65 - index);
 }
 
-static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table)
+static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table, unsigned int count)
 { // Generation of the precomputation table used internally by the double scalar multiplication function ecc_mul_double()
+  // Table[i] = (2i+1)*P for i < count
     point_extproj_t Q;
     point_extproj_precomp_t PP;
 
@@ -1815,26 +1818,17 @@ static void ecc_precomp_double(point_extproj_t P, point_extproj_precomp_t* Table
     eccdouble(P);                           // A = 2*P in (X,Y,Z,Ta,Tb)
     R1_to_R3(P, PP);                        // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,Z,T)
 
-    eccadd_core(Table[0], PP, Q);           // Table[i] = Table[i-1]+2P using the representations (X,Y,Z,Ta,Tb) <- (X+Y,Y-X,2Z,2dT) + (X+Y,Y-X,Z,T)
-    R1_to_R2(Q, Table[1]);                  // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
-
-    eccadd_core(Table[1], PP, Q);           // Table[i] = Table[i-1]+2P using the representations (X,Y,Z,Ta,Tb) <- (X+Y,Y-X,2Z,2dT) + (X+Y,Y-X,Z,T)
-    R1_to_R2(Q, Table[2]);                  // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
-
-    eccadd_core(Table[2], PP, Q);           // Table[i] = Table[i-1]+2P using the representations (X,Y,Z,Ta,Tb) <- (X+Y,Y-X,2Z,2dT) + (X+Y,Y-X,Z,T)
-    R1_to_R2(Q, Table[3]);                  // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
+    for (unsigned int i = 1; i < count; i++)
+    {
+        eccadd_core(Table[i - 1], PP, Q);   // Table[i] = Table[i-1]+2P using the representations (X,Y,Z,Ta,Tb) <- (X+Y,Y-X,2Z,2dT) + (X+Y,Y-X,Z,T)
+        R1_to_R2(Q, Table[i]);              // Converting from (X,Y,Z,Ta,Tb) to (X+Y,Y-X,2Z,2dT)
+    }
 }
 
-static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
-{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
-    // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
-    // The function uses wNAF with interleaving.
-    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
-    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
-    point_precomp_t V;
-    point_extproj_t Q1, Q2, Q3, Q4, T;
-    point_extproj_precomp_t U, Q_table1[4], Q_table2[4], Q_table3[4], Q_table4[4];
-    unsigned long long k_scalars[4], l_scalars[4];
+static bool ecc_precomp_key(point_t Q, point_extproj_precomp_t* Tables, unsigned int count)
+{ // Precomputation of ecc_mul_double() for the point Q: the odd multiples of Q, Phi(Q), Psi(Q) and Phi(Psi(Q)),
+  // count of each in Tables[0..count), Tables[count..2*count) and so on. False if Q does not lie on the curve
+    point_extproj_t Q1, Q2, Q3, Q4;
 
     point_setup(Q, Q1);                                             // Convert to representation (X,Y,1,Ta,Tb)
 
@@ -1863,20 +1857,41 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     *((__m256i*) & Q4->tb) = *((__m256i*) & Q2->tb);
     ecc_psi(Q4);
 
+    ecc_precomp_double(Q1, Tables, count);
+    ecc_precomp_double(Q2, Tables + count, count);
+    ecc_precomp_double(Q3, Tables + 2 * count, count);
+    ecc_precomp_double(Q4, Tables + 3 * count, count);
+
+    return true;
+}
+
+static void ecc_mul_double_precomputed(unsigned long long* k, unsigned long long* l, point_extproj_precomp_t* Tables, unsigned int w, point_t Q)
+{ // Double scalar multiplication Q = k*G + l*P, where the G is the generator and Tables is ecc_precomp_key() of P
+  // with 2^(w-2) points per table, l being recoded with window w
+  // Uses DOUBLE_SCALAR_TABLE, which contains multiples of G, Phi(G), Psi(G) and Phi(Psi(G))
+  // The function uses wNAF with interleaving.
+    const unsigned int count = 1 << (w - 2);
+    char digits_k1[65], digits_k2[65], digits_k3[65], digits_k4[65];
+    char digits_l1[65], digits_l2[65], digits_l3[65], digits_l4[65];
+    point_precomp_t V;
+    point_extproj_t T;
+    point_extproj_precomp_t U;
+    point_extproj_precomp_t* Q_table1 = Tables;
+    point_extproj_precomp_t* Q_table2 = Tables + count;
+    point_extproj_precomp_t* Q_table3 = Tables + 2 * count;
+    point_extproj_precomp_t* Q_table4 = Tables + 3 * count;
+    unsigned long long k_scalars[4], l_scalars[4];
+
     decompose((unsigned long long*)k, k_scalars);                   // Scalar decomposition
     decompose((unsigned long long*)l, l_scalars);
     wNAF_recode(k_scalars[0], 8, digits_k1);                        // Scalar recoding
     wNAF_recode(k_scalars[1], 8, digits_k2);
     wNAF_recode(k_scalars[2], 8, digits_k3);
     wNAF_recode(k_scalars[3], 8, digits_k4);
-    wNAF_recode(l_scalars[0], 4, digits_l1);
-    wNAF_recode(l_scalars[1], 4, digits_l2);
-    wNAF_recode(l_scalars[2], 4, digits_l3);
-    wNAF_recode(l_scalars[3], 4, digits_l4);
-    ecc_precomp_double(Q1, Q_table1);
-    ecc_precomp_double(Q2, Q_table2);
-    ecc_precomp_double(Q3, Q_table3);
-    ecc_precomp_double(Q4, Q_table4);
+    wNAF_recode(l_scalars[0], w, digits_l1);
+    wNAF_recode(l_scalars[1], w, digits_l2);
+    wNAF_recode(l_scalars[2], w, digits_l3);
+    wNAF_recode(l_scalars[3], w, digits_l4);
 
     T->x[0][0] = 0; T->x[0][1] = 0; T->x[1][0] = 0; T->x[1][1] = 0; // Initialize T as the neutral point (0:1:1)
     T->y[0][0] = 1; T->y[0][1] = 0; T->y[1][0] = 0; T->y[1][1] = 0;
@@ -1968,6 +1983,17 @@ static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t
     }
 
     eccnorm(T, Q);
+}
+
+static bool ecc_mul_double(unsigned long long* k, unsigned long long* l, point_t Q)
+{ // Double scalar multiplication R = k*G + l*Q, where the G is the generator
+    point_extproj_precomp_t Tables[4 * 4];
+
+    if (!ecc_precomp_key(Q, Tables, 4))
+    {
+        return false;
+    }
+    ecc_mul_double_precomputed(k, l, Tables, 4, Q);
 
     return true;
 }
@@ -2229,13 +2255,39 @@ VOID_FUNC_DECL sign(const unsigned char* subseed, const unsigned char* publicKey
     }
 }
 
-BOOL_FUNC_DECL verify(const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature)
-{
+static bool isCanonicalSignature(const unsigned char* signature)
+{ // Rejects encodings of R and s that verification could never accept
+    return !((signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63]);
+}
+
+static bool verifyWithDecodedKey(const point_t decodedKey, const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature)
+{ // SchnorrQ signature verification with publicKey already decoded into decodedKey
     point_t A;
     unsigned char temp[32 + 64];
     unsigned char h[64];
 
-    if ((publicKey[15] & 0x80) || (signature[15] & 0x80) || (signature[62] & 0xC0) || signature[63])
+    memcpy(A, decodedKey, sizeof(point_t));
+    memcpy(temp, signature, 32);
+    memcpy(temp + 32, publicKey, 32);
+    memcpy(temp + 64, messageDigest, 32);
+
+    KangarooTwelve(temp, 32 + 64, h, 64);
+
+    if (!ecc_mul_double((unsigned long long*)(signature + 32), (unsigned long long*)h, A))
+    {
+        return false;
+    }
+
+    encode(A, (unsigned char*)A);
+
+    return (memcmp(A, signature, 32) == 0);
+}
+
+BOOL_FUNC_DECL verify(const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature)
+{
+    point_t A;
+
+    if ((publicKey[15] & 0x80) || !isCanonicalSignature(signature))
     {
         return false;
     }
@@ -2244,18 +2296,98 @@ BOOL_FUNC_DECL verify(const unsigned char* publicKey, const unsigned char* messa
     {
         return false;
     }
+
+    return verifyWithDecodedKey(A, publicKey, messageDigest, signature);
+}
+
+#define VERIFY_TABLE_WINDOW 5                                // wNAF window of the public key scalar in verifyWithTable()
+#define VERIFY_TABLE_POINTS (1 << (VERIFY_TABLE_WINDOW - 2)) // odd multiples kept of the key point and of each of its images
+#ifndef VERIFY_TABLE_SIZE
+#define VERIFY_TABLE_SIZE 4096                               // bytes of a buildVerifyTable() table
+#endif
+static_assert(VERIFY_TABLE_SIZE == 4 * VERIFY_TABLE_POINTS * sizeof(point_extproj_precomp), "VERIFY_TABLE_SIZE is out of date");
+
+BOOL_FUNC_DECL buildVerifyTable(const unsigned char* publicKey, unsigned char* table)
+{ // Fills table (VERIFY_TABLE_SIZE bytes, 32 byte aligned: entries are read as __m256i) with the precomputation verifyWithTable() needs for publicKey.
+  // False if publicKey does not decode to a curve point, verify() then rejects every signature of it
+    point_t A;
+
+    if ((publicKey[15] & 0x80) || !decode(publicKey, A))
+    {
+        return false;
+    }
+
+    return ecc_precomp_key(A, (point_extproj_precomp_t*)table, VERIFY_TABLE_POINTS);
+}
+
+BOOL_FUNC_DECL verifyWithTable(const unsigned char* table, const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature)
+{ // verify() for a public key whose table buildVerifyTable() has built (32 byte aligned), skipping decoding and precomputation
+  // and with a wider window for the public key scalar
+    point_t A;
+    unsigned char temp[32 + 64];
+    unsigned char h[64];
+
+    if (!isCanonicalSignature(signature))
+    {
+        return false;
+    }
+
     memcpy(temp, signature, 32);
     memcpy(temp + 32, publicKey, 32);
     memcpy(temp + 64, messageDigest, 32);
 
     KangarooTwelve(temp, 32 + 64, h, 64);
 
-    if (!ecc_mul_double((unsigned long long*)(signature + 32), (unsigned long long*)h, A))
-    {
-        return false;
-    }
+    ecc_mul_double_precomputed((unsigned long long*)(signature + 32), (unsigned long long*)h, (point_extproj_precomp_t*)table, VERIFY_TABLE_WINDOW, A);
 
     encode(A, (unsigned char*)A);
 
     return (memcmp(A, signature, 32) == 0);
+}
+
+BOOL_FUNC_DECL verifyGroupedByKey(const unsigned char* publicKeys, const unsigned char* messageDigests, const unsigned char* signatures, unsigned int count, bool* results)
+{ // SchnorrQ verification of count signatures one by one (no batch equation), item i being publicKeys + 32*i, messageDigests + 32*i and signatures + 64*i
+  // results[i] is what verify() returns for item i, the return value tells whether all of them are valid.
+  // Items are checked grouped by public key so that each distinct key is decoded once, keys with several items get
+  // a buildVerifyTable() table, which costs about one precomputation more and saves one per item.
+    std::vector<unsigned int> order(count);
+    for (unsigned int i = 0; i < count; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [publicKeys](unsigned int a, unsigned int b)
+    {
+        return memcmp(publicKeys + 32 * a, publicKeys + 32 * b, 32) < 0;
+    });
+
+    point_t A;
+    alignas(32) unsigned char table[VERIFY_TABLE_SIZE];
+    bool allValid = true;
+    for (unsigned int j = 0; j < count; )
+    {
+        // decoding reads the key as __m256i, the caller's array gives no such alignment
+        alignas(32) unsigned char publicKey[32];
+        memcpy(publicKey, publicKeys + 32 * order[j], 32);
+        unsigned int end = j + 1;
+        while (end < count && memcmp(publicKeys + 32 * order[end], publicKey, 32) == 0) end++;
+        bool useTable = end - j > 1;
+        bool keyValid = useTable ? buildVerifyTable(publicKey, table) : !(publicKey[15] & 0x80) && decode(publicKey, A);
+        for (; j < end; j++)
+        {
+            unsigned int i = order[j];
+            const unsigned char* messageDigest = messageDigests + 32 * i;
+            const unsigned char* signature = signatures + 64 * i;
+            if (!keyValid)
+            {
+                results[i] = false;
+            }
+            else if (useTable)
+            {
+                results[i] = verifyWithTable(table, publicKey, messageDigest, signature);
+            }
+            else
+            {
+                results[i] = isCanonicalSignature(signature) && verifyWithDecodedKey(A, publicKey, messageDigest, signature);
+            }
+            allValid = allValid && results[i];
+        }
+    }
+    return allValid;
 }
\ No newline at end of file
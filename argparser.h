@@ -1,13 +1,15 @@
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <cerrno>
 #include <sstream>
 #include "logger.h"
+#include "daemon.h"
 
 #define CHECK_OVER_PARAMETERS if (i < argc)\
 { \
     LOG("Not accept any parameters after main COMMAND, unexpected %s\n", argv[i]); \
-    exit(1); \
+    cliExit(1); \
 }
 
 void print_help(){
@@ -23,14 +25,34 @@ void print_help(){
     printf("\t\tIP address of the target node for querying blockchain information (default: 127.0.0.1)\n");
     printf("\t-nodeport <PORT>\n");
     printf("\t\tPort of the target node for querying blockchain information (default: 21841)\n");
+    printf("\t-nodeips <IPv4_ADDRESS[:PORT],IPv4_ADDRESS[:PORT],...>\n");
+    printf("\t\tSend the query to several nodes at once. Supported by -getcurrenttick, -getbalance, -gettickdata and -qxgetfee\n");
+    printf("\t-policy <fastest|majority>\n");
+    printf("\t\tWhich answer of -nodeips to use: the first valid one, or the one more than half of the nodes agree on (the command fails if there is none) (default: fastest)\n");
+    printf("\t-nodelist <FILE>\n");
+    printf("\t\tRoute every command to the most up to date, lowest latency node of <FILE> (one IPv4_ADDRESS[:PORT] per line, as written by -crawlpeers), switching node mid-run if it lags, slows down or goes away (node switches are reported on stderr)\n");
+    printf("\t-record <FILE>\n");
+    printf("\t\tWrite every packet sent to and received from nodes, with timestamps, to <FILE>\n");
+    printf("\t-replay <FILE>\n");
+    printf("\t\tAnswer node requests from a capture made with -record instead of the network. Run the same command as when recording\n");
     printf("\t-scheduletick <TICK_OFFSET>\n");
     printf("\t\tOffset number of scheduled tick that will perform a transaction (default: 20)\n");
+    printf("\t-jobs <N>\n");
+    printf("\t\tNumber of -batch commands, of -gettickdatarange connections, or of threads verifying signatures for -readtickdata, -verifytickfiles, -getquorumtick and -quorumrange, run at once (default: 1)\n");
+    printf("\t-ratelimit <TICKS_PER_SECOND>\n");
+    printf("\t\tMaximum number of ticks -gettickdatarange fetches per second, over all connections (default: no limit)\n");
     printf("Command:\n");
+    printf("\t-daemon <SOCKET_PATH>\n");
+    printf("\t\tStay running and serve commands sent to the Unix domain socket <SOCKET_PATH>, keeping node connections warm. A request is the command with its parameters, either as a uint32 length followed by '\\0' terminated arguments, or as one JSON line {\"args\":[\"-getcurrenttick\"]}. The basic config given here applies to every request. -followticks and -archiveticks are refused since they do not end.\n");
+    printf("\t-batch <FILE>\n");
+    printf("\t\tRun the commands of <FILE> in one process, sharing node connections. One command with its parameters per line, '#' starts a comment. The basic config given here applies to every line, use -jobs to run several at once. Output stays in file order. -followticks and -archiveticks are refused since they do not end.\n");
     printf("[WALLET COMMAND]\n");
     printf("\t-showkeys\n");
     printf("\t\tGenerating identity, pubkey key from private key. Private key must be passed either from params or configuration file.\n");
     printf("\t-getbalance <IDENTITY>\n");
     printf("\t\tBalance of an identity (amount of qubic, number of in/out txs)\n");
+    printf("\t-getbalances <IDENTITY_LIST_FILE>\n");
+    printf("\t\tBalances of many identities, queried in one pipelined session. <IDENTITY_LIST_FILE> must contain one identity per line, lines that are not a valid identity are reported and skipped.\n");
     printf("\t-getasset <IDENTITY>\n");
     printf("\t\tPrint a list of assets of an identity\n");
     printf("\t-sendtoaddress <TARGET_IDENTITY> <AMOUNT>\n");
@@ -44,18 +66,38 @@ void print_help(){
     printf("\n[BLOCKCHAIN/PROTOCOL COMMAND]\n");
     printf("\t-gettickdata <TICK_NUMBER> <OUTPUT_FILE_NAME>\n");
     printf("\t\tGet tick data and write it to a file. Use -readtickdata to examine the file. valid node ip/port are required.\n");
+    printf("\t-gettickdatarange <FROM_TICK> <TO_TICK> <OUTPUT_DIR|ARCHIVE_FILE>\n");
+    printf("\t\tGet tick data and transactions of all ticks from <FROM_TICK> to <TO_TICK>. If <OUTPUT_DIR> is an existing directory one <TICK>.bin file per tick is written there in the -gettickdata file format (an empty <TICK>.empty file for an empty tick, once a quorum of computors voted for no tick data), otherwise ticks are appended to the tick archive <ARCHIVE_FILE> (one per epoch, see -archiveinfo). Uses -jobs connections, spread over the nodes of -nodeips if given, failed ticks are retried and ticks already written are skipped, so running it again resumes the download. valid node ip/port are required.\n");
+    printf("\t-archiveticks <ARCHIVE_FILE> [START_TICK]\n");
+    printf("\t\tKeep the tick archive <ARCHIVE_FILE> up to date from <START_TICK> on (default: the current tick) until the epoch ends. A tick is archived once its tick data is signed by its computor and all its transactions are there, or as empty once the node is well past it without tick data and a quorum of computors voted for no tick data. <ARCHIVE_FILE>.checkpoint keeps the last tick up to which the archive is complete, running the command again after a crash or node restart continues from there. valid node ip/port are required.\n");
+    printf("\t-archiveinfo <ARCHIVE_FILE>\n");
+    printf("\t\tPrint epoch, tick range, number of transactions and size of a tick archive written by -gettickdatarange.\n");
+    printf("\t-readarchivetick <ARCHIVE_FILE> <TICK_NUMBER> <OUTPUT_FILE_NAME>\n");
+    printf("\t\tWrite one tick of a tick archive to a file in the -gettickdata file format, to be examined with -readtickdata.\n");
+    printf("\t-followticks [START_TICK] [OUTPUT_FILE_NAME]\n");
+    printf("\t\tKeep one connection open and stream every new tick from <START_TICK> on (default: the current tick) as soon as the node is past it. Without <OUTPUT_FILE_NAME> (or with -) a line per tick and per transaction is printed, otherwise ticks are appended to <OUTPUT_FILE_NAME> in the -gettickdata file format. Runs until killed. valid node ip/port are required.\n");
     printf("\t-getquorumtick <COMP_LIST_FILE> <TICK_NUMBER>\n");
     printf("\t\tGet quorum tick data, the summary of quorum tick will be printed, <COMP_LIST_FILE> is fetched by command -getcomputorlist. valid node ip/port are required.\n");
+    printf("\t-quorumrange <COMP_LIST_FILE> <FROM_TICK> <TO_TICK> <OUTPUT_FILE>\n");
+    printf("\t\tCheck the quorum votes of every tick from <FROM_TICK> to <TO_TICK> like -getquorumtick, fetching them with pipelined requests. One line per tick (votes, bad signatures, salt failures, unique votes, majority size, votes not with the majority and the key of the majority vote) is written to <OUTPUT_FILE>: CSV on screen for -, CSV for a name ending in .csv, 48 byte binary records (QuorumTickSummary in quorumUtils.h) otherwise. The computors that missed a vote or cast a bad one are listed at the end. Uses -jobs threads. valid node ip/port are required.\n");
     printf("\t-getcomputorlist <OUTPUT_FILE_NAME>\n");
     printf("\t\tGet of the current epoch. Feed this data to -readtickdata to verify tick data. valid node ip/port are required.\n");
+    printf("\t-crawlpeers <DEPTH> <WIDTH> <OUTPUT_FILE_NAME>\n");
+    printf("\t\tDiscover nodes breadth first from the node's peers, up to <DEPTH> hops and <WIDTH> new nodes per hop, probing them concurrently. Reachable nodes are written to <OUTPUT_FILE_NAME> ranked by tick and latency. Valid node ip/port are required.\n");
     printf("\t-getnodeiplist\n");
     printf("\t\tPrint a list of node ip from a seed node ip. Valid node ip/port are required.\n");
     printf("\t-checktxontick <TICK_NUMBER> <TX_ID>\n");
     printf("\t\tCheck if a transaction is included in a tick. valid node ip/port are required.\n");
     printf("\t-checktxonfile <TX_ID> <TICK_DATA_FILE>\n");
-    printf("\t\tCheck if a transaction is included in a tick (tick data from a file). valid node ip/port are required.\n");
+    printf("\t\tCheck if a transaction is included in a tick (tick data from a file, or a tick archive).\n");
+    printf("\t-checktxonarchives <TX_ID> <ARCHIVE_FILE> [ARCHIVE_FILE ...]\n");
+    printf("\t\tCheck if a transaction is included in any of the tick archives written by -gettickdatarange. Archives indexed by -buildtxindex are looked up in their <ARCHIVE_FILE>.txidx, reading only the matching transaction, the others are scanned in memory. Nothing is written.\n");
+    printf("\t-buildtxindex <ARCHIVE_FILE> [ARCHIVE_FILE ...]\n");
+    printf("\t\tWrite the <ARCHIVE_FILE>.txidx transaction index used by -checktxonarchives next to each archive, when it is missing or the archive has grown since.\n");
     printf("\t-readtickdata <FILE_NAME> <COMPUTOR_LIST>\n");
     printf("\t\tRead tick data from a file, print the output on screen, COMPUTOR_LIST is required if you need to verify block data\n");
+    printf("\t-verifytickfiles <TICK_DATA_DIR_OR_ARCHIVE> <COMPUTOR_LIST>\n");
+    printf("\t\tVerify every tick of a directory of -gettickdata files (<TICK>.bin, as written by -gettickdatarange) or of a tick archive: tick data signed by its computor, every transaction signed by its source, and every announced transaction present. Ticks that fail are listed, followed by a summary. Uses -jobs threads.\n");
     printf("\t-sendcustomtransaction <TARGET_IDENTITY> <TX_TYPE> <AMOUNT> <EXTRA_BYTE_SIZE> <EXTRA_BYTE_IN_HEX>\n");
     printf("\t\tPerform a custom transaction (IPO, querying smart contract), valid private key and node ip/port are required.\n");
     printf("\t-dumpspectrumfile <SPECTRUM_BINARY_FILE> <OUTPUT_CSV_FILE>\n");
@@ -160,19 +202,23 @@ void readConfigFile(const char* path)
             v.push_back(substr);
         }
         memset(line, 0, 1000);
-        if (v[0] == "node_ip"){
+        // static buffers: the daemon reads the file again for every request
+        if (v[0] == "node_ip" && v.size() > 1){
             if ( strcmp(g_nodeIp, DEFAULT_NODE_IP) == 0 ){ // override when node ip is default value
-                g_nodeIp = (char*) malloc(64);
-                memset(g_nodeIp, 0, 64);
-                memcpy(g_nodeIp, v[1].c_str(), v[1].size());
-                if (g_nodeIp[v[1].size()-1] == '\n') g_nodeIp[v[1].size()-1] =0;
+                static thread_local char nodeIp[64];
+                memset(nodeIp, 0, sizeof(nodeIp));
+                memcpy(nodeIp, v[1].c_str(), std::min(v[1].size(), sizeof(nodeIp) - 1));
+                char* newline = strchr(nodeIp, '\n');
+                if (newline) *newline = 0;
+                g_nodeIp = nodeIp;
             }
         }
-        if (v[0] == "seed"){
+        if (v[0] == "seed" && v.size() > 1){
             if ( strcmp(g_seed, DEFAULT_SEED) == 0 ){ // override when seed is default value
-                g_seed = (char*) malloc(55);
-                memset(g_seed, 0, 55);
-                memcpy(g_seed, v[1].c_str(), 55);
+                static thread_local char seed[56];
+                memset(seed, 0, sizeof(seed));
+                memcpy(seed, v[1].c_str(), std::min(v[1].size(), size_t(55)));
+                g_seed = seed;
             }
         }
         if (v[0] == "node_port"){
@@ -203,7 +249,7 @@ void parseArgument(int argc, char** argv){
         /**********************
          ******BASIC CONFIG****
          **********************/
-        if(strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "-h") == 0) {print_help(); exit(0);}
+        if(strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "-h") == 0) {print_help(); cliExit(0);}
         if(strcmp(argv[i], "-conf") == 0)
         {
             g_configFile = argv[i+1];
@@ -228,6 +274,36 @@ void parseArgument(int argc, char** argv){
             i+=2;
             continue;
         }
+        if(strcmp(argv[i], "-nodeips") == 0)
+        {
+            g_nodeIps = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if(strcmp(argv[i], "-policy") == 0)
+        {
+            g_fanoutPolicy = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if(strcmp(argv[i], "-nodelist") == 0)
+        {
+            g_nodeListFile = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if(strcmp(argv[i], "-record") == 0)
+        {
+            g_recordFile = argv[i+1];
+            i+=2;
+            continue;
+        }
+        if(strcmp(argv[i], "-replay") == 0)
+        {
+            g_replayFile = argv[i+1];
+            i+=2;
+            continue;
+        }
         if(strcmp(argv[i], "-scheduletick") == 0)
         {
             g_offsetScheduledTick = int(charToNumber(argv[i+1]));
@@ -235,6 +311,20 @@ void parseArgument(int argc, char** argv){
             continue;
         }
 
+        if(strcmp(argv[i], "-ratelimit") == 0)
+        {
+            g_rateLimit = int(charToNumber(argv[i+1]));
+            i+=2;
+            continue;
+        }
+
+        if(strcmp(argv[i], "-jobs") == 0)
+        {
+            g_jobs = int(charToNumber(argv[i+1]));
+            i+=2;
+            continue;
+        }
+
         if(strcmp(argv[i], "-waituntilfinish") == 0)
         {
             g_waitUntilFinish = int(charToNumber(argv[i+1]));
@@ -246,6 +336,24 @@ void parseArgument(int argc, char** argv){
          ****WALLET COMMAND****
          **********************/
 
+        if(strcmp(argv[i], "-daemon") == 0)
+        {
+            g_cmd = RUN_DAEMON;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+
+        if(strcmp(argv[i], "-batch") == 0)
+        {
+            g_cmd = RUN_BATCH;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+
         if(strcmp(argv[i], "-showkeys") == 0)
         {
             g_cmd = SHOW_KEYS;
@@ -263,6 +371,15 @@ void parseArgument(int argc, char** argv){
             break;
         }
 
+        if(strcmp(argv[i], "-getbalances") == 0)
+        {
+            g_cmd = GET_BALANCES;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+
         if(strcmp(argv[i], "-getasset") == 0)
         {
             g_cmd = GET_ASSET;
@@ -305,6 +422,52 @@ void parseArgument(int argc, char** argv){
             CHECK_OVER_PARAMETERS
             break;
         }
+        if(strcmp(argv[i], "-gettickdatarange") == 0)
+        {
+            g_cmd = GET_TICK_DATA_RANGE;
+            g_requestedTickNumber = charToNumber(argv[i+1]);
+            g_requestedTickNumber2 = charToNumber(argv[i+2]);
+            g_requestedFileName = argv[i+3];
+            i+=4;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if(strcmp(argv[i], "-archiveticks") == 0)
+        {
+            g_cmd = ARCHIVE_TICKS;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            if (i < argc) g_requestedTickNumber = charToNumber(argv[i++]);
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if(strcmp(argv[i], "-archiveinfo") == 0)
+        {
+            g_cmd = ARCHIVE_INFO;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if(strcmp(argv[i], "-readarchivetick") == 0)
+        {
+            g_cmd = READ_ARCHIVE_TICK;
+            g_requestedFileName = argv[i+1];
+            g_requestedTickNumber = charToNumber(argv[i+2]);
+            g_requestedFileName2 = argv[i+3];
+            i+=4;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if(strcmp(argv[i], "-followticks") == 0)
+        {
+            g_cmd = FOLLOW_TICKS;
+            i++;
+            if (i < argc) g_requestedTickNumber = charToNumber(argv[i++]);
+            if (i < argc) g_requestedFileName = argv[i++];
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if(strcmp(argv[i], "-getquorumtick") == 0)
         {
             g_cmd = GET_QUORUM_TICK;
@@ -314,6 +477,17 @@ void parseArgument(int argc, char** argv){
             CHECK_OVER_PARAMETERS
             break;
         }
+        if(strcmp(argv[i], "-quorumrange") == 0)
+        {
+            g_cmd = QUORUM_RANGE;
+            g_requestedFileName = argv[i+1];
+            g_requestedTickNumber = charToNumber(argv[i+2]);
+            g_requestedTickNumber2 = charToNumber(argv[i+3]);
+            g_requestedFileName2 = argv[i+4];
+            i+=5;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if(strcmp(argv[i], "-getcomputorlist") == 0)
         {
             g_cmd = GET_COMP_LIST;
@@ -322,6 +496,16 @@ void parseArgument(int argc, char** argv){
             CHECK_OVER_PARAMETERS
             break;
         }
+        if(strcmp(argv[i], "-crawlpeers") == 0)
+        {
+            g_cmd = CRAWL_PEERS;
+            g_crawlDepth = int(charToNumber(argv[i+1]));
+            g_crawlWidth = int(charToNumber(argv[i+2]));
+            g_requestedFileName = argv[i+3];
+            i+=4;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if(strcmp(argv[i], "-getnodeiplist") == 0)
         {
             g_cmd = GET_NODE_IP_LIST;
@@ -338,6 +522,23 @@ void parseArgument(int argc, char** argv){
             CHECK_OVER_PARAMETERS
             break;
         }
+        if(strcmp(argv[i], "-checktxonarchives") == 0)
+        {
+            g_cmd = CHECK_TX_ON_ARCHIVES;
+            g_requestedTxId = argv[i+1];
+            g_requestedFiles = argv + i + 2;
+            g_requestedFileCount = argc - i - 2;
+            i = argc;
+            break;
+        }
+        if(strcmp(argv[i], "-buildtxindex") == 0)
+        {
+            g_cmd = BUILD_TX_INDEX;
+            g_requestedFiles = argv + i + 1;
+            g_requestedFileCount = argc - i - 1;
+            i = argc;
+            break;
+        }
         if(strcmp(argv[i], "-checktxonfile") == 0)
         {
             g_cmd = CHECK_TX_ON_FILE;
@@ -347,6 +548,15 @@ void parseArgument(int argc, char** argv){
             CHECK_OVER_PARAMETERS
             break;
         }
+        if(strcmp(argv[i], "-verifytickfiles") == 0)
+        {
+            g_cmd = VERIFY_TICK_FILES;
+            g_requestedFileName = argv[i+1];
+            g_requestedFileName2 = argv[i+2];
+            i+=3;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if(strcmp(argv[i], "-readtickdata") == 0)
         {
             g_cmd = READ_TICK_DATA;
@@ -412,7 +622,7 @@ void parseArgument(int argc, char** argv){
         if(strcmp(argv[i], "-publishproposal") == 0)
         {
             LOG("On development\n");
-            exit(0);
+            cliExit(0);
         }
 
         /**********************
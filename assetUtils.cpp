@@ -25,7 +25,7 @@ std::vector<RespondOwnedAssets> getOwnedAsset(const char * nodeIp, const int nod
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {END_RESPONSE});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -56,7 +56,7 @@ std::vector<RespondPossessedAssets> getPossessionAsset(const char * nodeIp, cons
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {END_RESPONSE});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -105,7 +105,7 @@ void printAssetDigest(T& respondedAsset)
 {
     uint8_t assetDigest[32];
     getAssetDigest(respondedAsset, assetDigest);
-    char hex_digest[64];
+    char hex_digest[65];
     byteToHex(assetDigest, hex_digest, 32);
     LOG("Asset Digest: %s\n", hex_digest);
 }
@@ -0,0 +1,503 @@
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "asyncConnection.h"
+#include "logger.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+AsyncNodeEngine::AsyncNodeEngine(int requestTimeoutMs)
+{
+    mTimeoutMs = requestTimeoutMs;
+    mPending = 0;
+    mStop = false;
+    mEpoll = epoll_create1(0);
+    mWakeFd = eventfd(0, EFD_NONBLOCK);
+    if (mEpoll < 0 || mWakeFd < 0)
+        throw std::logic_error("Failed to create epoll instance.");
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr; // the wake up fd is the only one without a NodeSocket
+    epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeFd, &ev);
+}
+
+AsyncNodeEngine::~AsyncNodeEngine()
+{
+    stop();
+    drainSubmissions();
+    std::vector<NodeSocket*> nodes;
+    for (auto& item : mNodes) nodes.push_back(item.second);
+    for (auto node : nodes) failNode(node);
+    for (auto node : mDeadNodes) delete node;
+    close(mWakeFd);
+    close(mEpoll);
+}
+
+void AsyncNodeEngine::submit(const char* nodeIp, int nodePort, const std::vector<uint8_t>& packet, uint8_t responseType, AsyncCallback callback)
+{
+    Submission s;
+    s.ip = nodeIp;
+    s.port = nodePort;
+    s.request.packet = packet;
+    s.request.responseType = responseType;
+    s.request.callback = callback;
+    mPending++;
+    {
+        std::lock_guard<std::mutex> guard(mSubmitLock);
+        mSubmissions.push_back(s);
+    }
+    wake();
+}
+
+std::future<AsyncResponse> AsyncNodeEngine::submit(const char* nodeIp, int nodePort, const std::vector<uint8_t>& packet, uint8_t responseType)
+{
+    auto promise = std::make_shared<std::promise<AsyncResponse>>();
+    submit(nodeIp, nodePort, packet, responseType, [promise](const AsyncResponse& response)
+    {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+void AsyncNodeEngine::expect(const char* nodeIp, int nodePort, uint8_t type, AsyncCallback callback)
+{
+    submit(nodeIp, nodePort, std::vector<uint8_t>(), type, callback);
+}
+
+template <typename T>
+static std::future<AsyncResult<T>> submitTyped(AsyncNodeEngine* engine, const char* nodeIp, int nodePort,
+                                               const std::vector<uint8_t>& packet, uint8_t responseType)
+{
+    auto promise = std::make_shared<std::promise<AsyncResult<T>>>();
+    engine->submit(nodeIp, nodePort, packet, responseType, [promise, responseType](const AsyncResponse& response)
+    {
+        AsyncResult<T> result;
+        memset(&result.value, 0, sizeof(T));
+        result.ok = response.ok;
+        result.connectMs = response.connectMs;
+        result.rttMs = response.rttMs;
+        if (response.ok && response.type == responseType)
+        {
+            if (response.payload.size() >= sizeof(T))
+                memcpy(&result.value, response.payload.data(), sizeof(T));
+            else
+                result.ok = false;
+        }
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+template <typename T>
+static std::vector<uint8_t> makePacket(uint8_t type, const T& body)
+{
+    struct {
+        RequestResponseHeader header;
+        T body;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(type);
+    packet.body = body;
+    return std::vector<uint8_t>((uint8_t*)&packet, (uint8_t*)&packet + sizeof(packet));
+}
+
+std::future<AsyncResult<CurrentTickInfo>> AsyncNodeEngine::requestTickInfo(const char* nodeIp, int nodePort)
+{
+    RequestResponseHeader header;
+    header.setSize(sizeof(header));
+    header.randomizeDejavu();
+    header.setType(REQUEST_CURRENT_TICK_INFO);
+    std::vector<uint8_t> packet((uint8_t*)&header, (uint8_t*)&header + sizeof(header));
+    return submitTyped<CurrentTickInfo>(this, nodeIp, nodePort, packet, RESPOND_CURRENT_TICK_INFO);
+}
+
+std::future<AsyncResult<RespondedEntity>> AsyncNodeEngine::requestEntity(const char* nodeIp, int nodePort, const uint8_t* publicKey)
+{
+    RequestedEntity req;
+    memcpy(req.publicKey, publicKey, 32);
+    return submitTyped<RespondedEntity>(this, nodeIp, nodePort, makePacket(REQUEST_ENTITY, req), RESPOND_ENTITY);
+}
+
+std::future<AsyncResult<TickData>> AsyncNodeEngine::requestTickData(const char* nodeIp, int nodePort, uint32_t tick)
+{
+    RequestTickData req;
+    req.requestedTickData.tick = tick;
+    return submitTyped<TickData>(this, nodeIp, nodePort, makePacket(REQUEST_TICK_DATA, req), BROADCAST_FUTURE_TICK_DATA);
+}
+
+std::future<AsyncResponse> AsyncNodeEngine::requestContractFunction(const char* nodeIp, int nodePort, uint32_t contractIndex,
+                                                                    uint16_t inputType, const void* input, uint16_t inputSize)
+{
+    std::vector<uint8_t> packet(sizeof(RequestResponseHeader) + sizeof(RequestContractFunction) + inputSize);
+    auto header = (RequestResponseHeader*)packet.data();
+    header->setSize(packet.size());
+    header->randomizeDejavu();
+    header->setType(RequestContractFunction::type());
+    auto rcf = (RequestContractFunction*)(packet.data() + sizeof(RequestResponseHeader));
+    rcf->contractIndex = contractIndex;
+    rcf->inputType = inputType;
+    rcf->inputSize = inputSize;
+    if (inputSize) memcpy(packet.data() + sizeof(RequestResponseHeader) + sizeof(RequestContractFunction), input, inputSize);
+    return submit(nodeIp, nodePort, packet, RespondContractFunction::type());
+}
+
+void AsyncNodeEngine::wake()
+{
+    uint64_t one = 1;
+    if (write(mWakeFd, &one, sizeof(one)) < 0)
+    {
+        // counter is already non-zero, the loop will wake up anyway
+    }
+}
+
+void AsyncNodeEngine::drainSubmissions()
+{
+    std::vector<Submission> submissions;
+    {
+        std::lock_guard<std::mutex> guard(mSubmitLock);
+        submissions.swap(mSubmissions);
+    }
+    for (auto& s : submissions)
+    {
+        std::string key = s.ip + ":" + std::to_string(s.port);
+        auto it = mNodes.find(key);
+        NodeSocket* node = (it == mNodes.end()) ? openNode(s.ip, s.port) : it->second;
+        if (!node)
+        {
+            mPending--;
+            AsyncResponse response;
+            response.ok = false;
+            response.type = 0;
+            response.connectMs = 0;
+            response.rttMs = 0;
+            s.request.callback(response);
+            continue;
+        }
+        sendRequest(node, s.request);
+    }
+}
+
+AsyncNodeEngine::NodeSocket* AsyncNodeEngine::openNode(const std::string& ip, int port)
+{
+    sockaddr_in addr;
+    memset((char*)&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0)
+    {
+        LOG("Error translating ip address %s to usable one.\n", ip.c_str());
+        return nullptr;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) return nullptr;
+    if (connect(fd, (const sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+    {
+        close(fd);
+        return nullptr;
+    }
+    NodeSocket* node = new NodeSocket();
+    node->ip = ip;
+    node->port = port;
+    node->fd = fd;
+    node->connected = false;
+    node->wantWrite = true;
+    node->connectStart = std::chrono::steady_clock::now();
+    node->connectMs = 0;
+    node->connectReported = false;
+    node->outOffset = 0;
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = node;
+    epoll_ctl(mEpoll, EPOLL_CTL_ADD, fd, &ev);
+    mNodes[ip + ":" + std::to_string(port)] = node;
+    return node;
+}
+
+void AsyncNodeEngine::sendRequest(NodeSocket* node, Request& request)
+{
+    // expect() has no packet, it only needs a key that no answer carries (unsolicited packets have dejavu 0)
+    RequestResponseHeader unsent;
+    auto header = request.packet.empty() ? &unsent : (RequestResponseHeader*)request.packet.data();
+    do
+    {
+        header->randomizeDejavu();
+    } while (node->inFlight.count(header->dejavu()));
+    unsigned int dejavu = header->dejavu();
+    node->out.insert(node->out.end(), request.packet.begin(), request.packet.end());
+    request.sentAt = std::chrono::steady_clock::now();
+    request.deadline = request.sentAt + std::chrono::milliseconds(mTimeoutMs);
+    node->order.push_back(dejavu);
+    node->inFlight[dejavu] = request;
+    if (node->connected) flush(node);
+}
+
+void AsyncNodeEngine::updateEvents(NodeSocket* node)
+{
+    bool wantWrite = !node->connected || node->outOffset < node->out.size();
+    if (wantWrite == node->wantWrite) return;
+    node->wantWrite = wantWrite;
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (wantWrite ? uint32_t(EPOLLOUT) : 0);
+    ev.data.ptr = node;
+    epoll_ctl(mEpoll, EPOLL_CTL_MOD, node->fd, &ev);
+}
+
+void AsyncNodeEngine::flush(NodeSocket* node)
+{
+    while (node->outOffset < node->out.size())
+    {
+        ssize_t n = send(node->fd, node->out.data() + node->outOffset, node->out.size() - node->outOffset, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            failNode(node);
+            return;
+        }
+        node->outOffset += n;
+    }
+    if (node->outOffset == node->out.size())
+    {
+        node->out.clear();
+        node->outOffset = 0;
+    }
+    updateEvents(node);
+}
+
+void AsyncNodeEngine::onWritable(NodeSocket* node)
+{
+    if (!node->connected)
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(node->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0)
+        {
+            failNode(node);
+            return;
+        }
+        node->connected = true;
+        node->connectMs = elapsedMs(node->connectStart, std::chrono::steady_clock::now());
+        // the clock for requests queued while connecting starts now
+        auto now = std::chrono::steady_clock::now();
+        for (auto& item : node->inFlight)
+        {
+            item.second.sentAt = now;
+            item.second.deadline = now + std::chrono::milliseconds(mTimeoutMs);
+        }
+    }
+    flush(node);
+}
+
+void AsyncNodeEngine::onReadable(NodeSocket* node)
+{
+    uint8_t tmp[65536];
+    bool closed = false;
+    while (true)
+    {
+        ssize_t n = recv(node->fd, tmp, sizeof(tmp), 0);
+        if (n > 0)
+        {
+            node->in.insert(node->in.end(), tmp, tmp + n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // closed by the node or socket error, parse what arrived and fail the rest
+        closed = true;
+        break;
+    }
+    size_t ptr = 0;
+    while (node->in.size() - ptr >= sizeof(RequestResponseHeader))
+    {
+        auto header = (RequestResponseHeader*)(node->in.data() + ptr);
+        size_t packetSize = header->size();
+        if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+        {
+            failNode(node);
+            return;
+        }
+        if (node->in.size() - ptr < packetSize) break;
+        const uint8_t* payload = node->in.data() + ptr + sizeof(RequestResponseHeader);
+        size_t payloadSize = packetSize - sizeof(RequestResponseHeader);
+        uint8_t type = header->type();
+        auto it = node->inFlight.find(header->dejavu());
+        if (it != node->inFlight.end())
+        {
+            if (type == it->second.responseType || type == END_RESPONSE)
+                finish(node, it->first, true, type, payload, payloadSize);
+        }
+        else
+        {
+            for (unsigned int dejavu : node->order)
+            {
+                if (node->inFlight[dejavu].responseType == type)
+                {
+                    finish(node, dejavu, true, type, payload, payloadSize);
+                    break;
+                }
+            }
+        }
+        ptr += packetSize;
+    }
+    node->in.erase(node->in.begin(), node->in.begin() + ptr);
+
+    if (closed)
+    {
+        failNode(node);
+    }
+}
+
+void AsyncNodeEngine::finish(NodeSocket* node, unsigned int dejavu, bool ok, uint8_t type, const uint8_t* payload, size_t payloadSize)
+{
+    auto it = node->inFlight.find(dejavu);
+    if (it == node->inFlight.end()) return;
+    Request request = it->second;
+    node->inFlight.erase(it);
+    for (auto o = node->order.begin(); o != node->order.end(); o++)
+    {
+        if (*o == dejavu)
+        {
+            node->order.erase(o);
+            break;
+        }
+    }
+    AsyncResponse response;
+    response.ok = ok;
+    response.type = type;
+    if (payloadSize) response.payload.assign(payload, payload + payloadSize);
+    response.connectMs = 0;
+    if (ok && !node->connectReported)
+    {
+        response.connectMs = node->connectMs;
+        node->connectReported = true;
+    }
+    response.rttMs = ok ? elapsedMs(request.sentAt, std::chrono::steady_clock::now()) : 0;
+    mPending--;
+    request.callback(response);
+}
+
+void AsyncNodeEngine::failNode(NodeSocket* node)
+{
+    if (node->fd >= 0)
+    {
+        epoll_ctl(mEpoll, EPOLL_CTL_DEL, node->fd, nullptr);
+        close(node->fd);
+        node->fd = -1;
+    }
+    while (!node->order.empty())
+    {
+        finish(node, node->order.front(), false, 0, nullptr, 0);
+    }
+    // forget the session, the next request to this node opens a new one
+    auto it = mNodes.find(node->ip + ":" + std::to_string(node->port));
+    if (it != mNodes.end() && it->second == node)
+    {
+        mNodes.erase(it);
+        mDeadNodes.push_back(node);
+    }
+}
+
+void AsyncNodeEngine::expireRequests()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<NodeSocket*> nodes;
+    for (auto& item : mNodes) nodes.push_back(item.second);
+    for (auto node : nodes)
+    {
+        if (!node->connected && !node->inFlight.empty() && elapsedMs(node->connectStart, now) > mTimeoutMs)
+        {
+            failNode(node);
+            continue;
+        }
+        std::vector<unsigned int> expired;
+        for (auto& item : node->inFlight)
+        {
+            if (item.second.deadline < now) expired.push_back(item.first);
+        }
+        for (auto dejavu : expired) finish(node, dejavu, false, 0, nullptr, 0);
+    }
+}
+
+size_t AsyncNodeEngine::poll(int timeoutMs)
+{
+    drainSubmissions();
+    epoll_event events[256];
+    int n = epoll_wait(mEpoll, events, 256, timeoutMs);
+    for (int i = 0; i < n; i++)
+    {
+        auto node = (NodeSocket*)events[i].data.ptr;
+        if (!node)
+        {
+            uint64_t counter;
+            if (read(mWakeFd, &counter, sizeof(counter)) < 0)
+            {
+                // spurious wake up
+            }
+            continue;
+        }
+        if (node->fd < 0) continue; // failed earlier in this round
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+            if (!node->connected)
+            {
+                failNode(node);
+                continue;
+            }
+            onReadable(node); // take whatever arrived before the hang up
+            if (node->fd >= 0) failNode(node);
+            continue;
+        }
+        if (events[i].events & EPOLLOUT) onWritable(node);
+        if (node->fd >= 0 && (events[i].events & EPOLLIN)) onReadable(node);
+    }
+    expireRequests();
+    for (auto node : mDeadNodes) delete node;
+    mDeadNodes.clear();
+    drainSubmissions();
+    return mPending;
+}
+
+void AsyncNodeEngine::run()
+{
+    while (mPending > 0)
+    {
+        poll(50);
+    }
+}
+
+void AsyncNodeEngine::start()
+{
+    if (mThread.joinable()) return;
+    mStop = false;
+    mThread = std::thread([this]()
+    {
+        while (!mStop)
+        {
+            poll(50);
+        }
+    });
+}
+
+void AsyncNodeEngine::stop()
+{
+    if (!mThread.joinable()) return;
+    mStop = true;
+    wake();
+    mThread.join();
+}
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "structs.h"
+
+// Answer of one request sent through AsyncNodeEngine
+struct AsyncResponse
+{
+    bool ok;                      // false if the node could not be reached, closed the socket or timed out
+    uint8_t type;                 // type of the answer packet, END_RESPONSE if the node had nothing to send
+    std::vector<uint8_t> payload; // answer without RequestResponseHeader
+    double connectMs;             // time to establish the TCP session (0 if it was already open)
+    double rttMs;                 // time from sending the request to receiving the answer
+};
+
+template <typename T>
+struct AsyncResult
+{
+    bool ok;
+    T value; // zeroed if !ok or if the node answered with END_RESPONSE
+    double connectMs;
+    double rttMs;
+};
+
+typedef std::function<void(const AsyncResponse&)> AsyncCallback;
+
+#ifdef __linux__
+// Non-blocking multi-node client built on epoll. One TCP session is kept per ip:port and all
+// requests to that node are pipelined over it, answers are routed back by their dejavu.
+// Callbacks run on the thread that drives the engine: either the caller of poll()/run() or the
+// background thread of start(). Requests may be submitted from any thread, including from callbacks.
+class AsyncNodeEngine
+{
+public:
+    explicit AsyncNodeEngine(int requestTimeoutMs = 2000);
+    ~AsyncNodeEngine();
+
+    // packet must be a complete packet starting with RequestResponseHeader, its dejavu is overwritten.
+    // The request completes with the first packet of responseType (or END_RESPONSE) carrying its dejavu.
+    void submit(const char* nodeIp, int nodePort, const std::vector<uint8_t>& packet, uint8_t responseType, AsyncCallback callback);
+    std::future<AsyncResponse> submit(const char* nodeIp, int nodePort, const std::vector<uint8_t>& packet, uint8_t responseType);
+    // Sends nothing, completes with the next packet of type the node sends on its own (e.g. the
+    // EXCHANGE_PUBLIC_PEERS announced when a session opens), or fails at the timeout like a request
+    void expect(const char* nodeIp, int nodePort, uint8_t type, AsyncCallback callback);
+
+    std::future<AsyncResult<CurrentTickInfo>> requestTickInfo(const char* nodeIp, int nodePort);
+    std::future<AsyncResult<RespondedEntity>> requestEntity(const char* nodeIp, int nodePort, const uint8_t* publicKey);
+    std::future<AsyncResult<TickData>> requestTickData(const char* nodeIp, int nodePort, uint32_t tick);
+    std::future<AsyncResponse> requestContractFunction(const char* nodeIp, int nodePort, uint32_t contractIndex,
+                                                       uint16_t inputType, const void* input, uint16_t inputSize);
+
+    // Handles socket events for at most timeoutMs and returns the number of unfinished requests.
+    // Must not be used while the background thread of start() is running.
+    size_t poll(int timeoutMs);
+    // Drives the engine until every submitted request has completed
+    void run();
+    // Drives the engine from a background thread, so futures can simply be waited on
+    void start();
+    void stop();
+    size_t pending() const { return mPending; }
+
+private:
+    struct Request
+    {
+        std::vector<uint8_t> packet;
+        uint8_t responseType;
+        AsyncCallback callback;
+        std::chrono::steady_clock::time_point sentAt;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    struct NodeSocket
+    {
+        std::string ip;
+        int port;
+        int fd;
+        bool connected;
+        bool wantWrite;
+        std::chrono::steady_clock::time_point connectStart;
+        double connectMs;
+        bool connectReported; // connectMs is only attributed to the first answer on the session
+        std::vector<uint8_t> out;
+        size_t outOffset;
+        std::vector<uint8_t> in;
+        std::map<unsigned int, Request> inFlight; // dejavu -> request
+        std::deque<unsigned int> order;           // dejavus in sending order
+    };
+    struct Submission
+    {
+        std::string ip;
+        int port;
+        Request request;
+    };
+
+    void drainSubmissions();
+    NodeSocket* openNode(const std::string& ip, int port);
+    void sendRequest(NodeSocket* node, Request& request);
+    void flush(NodeSocket* node);
+    void updateEvents(NodeSocket* node);
+    void onReadable(NodeSocket* node);
+    void onWritable(NodeSocket* node);
+    void finish(NodeSocket* node, unsigned int dejavu, bool ok, uint8_t type, const uint8_t* payload, size_t payloadSize);
+    void failNode(NodeSocket* node);
+    void expireRequests();
+    void wake();
+
+    int mTimeoutMs;
+    int mEpoll;
+    int mWakeFd;
+    std::map<std::string, NodeSocket*> mNodes;
+    std::vector<NodeSocket*> mDeadNodes; // failed during the current poll, freed at its end
+    std::mutex mSubmitLock;
+    std::vector<Submission> mSubmissions;
+    std::atomic<size_t> mPending;
+    std::atomic<bool> mStop;
+    std::thread mThread;
+};
+#endif
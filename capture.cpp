@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "capture.h"
+#include "connection.h"
+#include "logger.h"
+
+namespace
+{
+    std::mutex gCaptureLock;
+    FILE* gRecordFile = nullptr;
+    uint32_t gNextConnectionId = 1;
+    std::chrono::steady_clock::time_point gRecordStart;
+
+    struct RecordedPacket
+    {
+        std::vector<uint8_t> data;
+        size_t sentBefore; // number of requests sent on the session before this packet was complete
+    };
+
+    struct RecordedSession
+    {
+        std::vector<uint8_t> sentBytes;
+        std::vector<uint8_t> receivedBytes;
+        std::vector<unsigned int> sentDejavus;
+        std::vector<RecordedPacket> received;
+    };
+
+    bool gReplaying = false;
+    std::map<std::string, std::deque<std::shared_ptr<RecordedSession>>> gReplaySessions; // ip:port -> sessions in recording order
+
+    std::string nodeKey(const char* nodeIp, int nodePort)
+    {
+        return std::string(nodeIp) + ":" + std::to_string(nodePort);
+    }
+
+    // Moves the complete packets at the front of bytes to out, keeps the rest
+    template <typename F>
+    void takePackets(std::vector<uint8_t>& bytes, F out)
+    {
+        auto packets = splitPackets(bytes.data(), bytes.size());
+        size_t used = 0;
+        for (auto& packet : packets)
+        {
+            out(bytes.data() + used, packet.size(), packet.dejavu());
+            used += packet.size();
+        }
+        bytes.erase(bytes.begin(), bytes.begin() + used);
+    }
+}
+
+class ReplaySession
+{
+public:
+    explicit ReplaySession(std::shared_ptr<RecordedSession> recorded) : mRecorded(recorded), mNext(0), mOffset(0) {}
+
+    int send(const uint8_t* buffer, int size)
+    {
+        mSentBytes.insert(mSentBytes.end(), buffer, buffer + size);
+        takePackets(mSentBytes, [this](const uint8_t*, size_t, unsigned int dejavu)
+        {
+            mLiveDejavus.push_back(dejavu);
+        });
+        return size;
+    }
+
+    int recv(uint8_t* buffer, int size)
+    {
+        int copied = 0;
+        while (copied < size)
+        {
+            if (mOffset == mCurrent.size())
+            {
+                if (!nextPacket()) break;
+            }
+            size_t n = std::min(size_t(size - copied), mCurrent.size() - mOffset);
+            memcpy(buffer + copied, mCurrent.data() + mOffset, n);
+            mOffset += n;
+            copied += int(n);
+        }
+        return copied ? copied : -1;
+    }
+
+private:
+    bool nextPacket()
+    {
+        auto& received = mRecorded->received;
+        if (mNext >= received.size() || received[mNext].sentBefore > mLiveDejavus.size()) return false;
+        mCurrent = received[mNext++].data;
+        mOffset = 0;
+        // answers echo the dejavu of their request, which is random on every run
+        auto header = (RequestResponseHeader*)mCurrent.data();
+        auto& sent = mRecorded->sentDejavus;
+        for (size_t i = 0; i < sent.size() && i < mLiveDejavus.size(); i++)
+        {
+            if (sent[i] && sent[i] == header->dejavu())
+            {
+                header->setDejavu(mLiveDejavus[i]);
+                break;
+            }
+        }
+        return true;
+    }
+
+    std::shared_ptr<RecordedSession> mRecorded;
+    std::vector<uint8_t> mSentBytes;
+    std::vector<unsigned int> mLiveDejavus;
+    size_t mNext;
+    std::vector<uint8_t> mCurrent;
+    size_t mOffset;
+};
+
+bool startCaptureRecording(const char* fileName)
+{
+    std::lock_guard<std::mutex> guard(gCaptureLock);
+    gRecordFile = fopen(fileName, "wb");
+    if (!gRecordFile) return false;
+    uint32_t version = CAPTURE_VERSION;
+    fwrite(CAPTURE_MAGIC, 1, 4, gRecordFile);
+    fwrite(&version, 1, sizeof(version), gRecordFile);
+    fflush(gRecordFile);
+    gRecordStart = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool isCaptureRecording()
+{
+    return gRecordFile != nullptr;
+}
+
+static void writeRecord(uint32_t connectionId, CaptureDirection direction, const uint8_t* data, uint32_t length)
+{
+    CaptureRecord record;
+    record.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gRecordStart).count();
+    record.connectionId = connectionId;
+    record.direction = direction;
+    record.length = length;
+    fwrite(&record, 1, sizeof(record), gRecordFile);
+    if (length) fwrite(data, 1, length, gRecordFile);
+    // flushed per record, the cli may exit() in the middle of a command
+    fflush(gRecordFile);
+}
+
+uint32_t captureOpen(const char* nodeIp, int nodePort)
+{
+    std::lock_guard<std::mutex> guard(gCaptureLock);
+    uint32_t id = gNextConnectionId++;
+    std::string key = nodeKey(nodeIp, nodePort);
+    writeRecord(id, CAPTURE_CONNECT, (const uint8_t*)key.data(), uint32_t(key.size()));
+    return id;
+}
+
+void captureWrite(uint32_t connectionId, CaptureDirection direction, const uint8_t* data, uint32_t length)
+{
+    std::lock_guard<std::mutex> guard(gCaptureLock);
+    writeRecord(connectionId, direction, data, length);
+}
+
+bool startCaptureReplay(const char* fileName)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f) return false;
+    char magic[4];
+    uint32_t version = 0;
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, CAPTURE_MAGIC, 4) != 0
+        || fread(&version, 1, sizeof(version), f) != sizeof(version) || version != CAPTURE_VERSION)
+    {
+        fclose(f);
+        return false;
+    }
+    std::map<uint32_t, std::shared_ptr<RecordedSession>> sessions;
+    std::vector<uint8_t> data;
+    CaptureRecord record;
+    while (fread(&record, 1, sizeof(record), f) == sizeof(record))
+    {
+        data.resize(record.length);
+        if (record.length && fread(data.data(), 1, record.length, f) != record.length) break;
+        if (record.direction == CAPTURE_CONNECT)
+        {
+            std::shared_ptr<RecordedSession> session(new RecordedSession());
+            sessions[record.connectionId] = session;
+            gReplaySessions[std::string(data.begin(), data.end())].push_back(session);
+            continue;
+        }
+        auto it = sessions.find(record.connectionId);
+        if (it == sessions.end()) continue;
+        RecordedSession& session = *it->second;
+        if (record.direction == CAPTURE_SENT)
+        {
+            session.sentBytes.insert(session.sentBytes.end(), data.begin(), data.end());
+            takePackets(session.sentBytes, [&session](const uint8_t*, size_t, unsigned int dejavu)
+            {
+                session.sentDejavus.push_back(dejavu);
+            });
+        }
+        else if (record.direction == CAPTURE_RECEIVED)
+        {
+            session.receivedBytes.insert(session.receivedBytes.end(), data.begin(), data.end());
+            takePackets(session.receivedBytes, [&session](const uint8_t* packet, size_t size, unsigned int)
+            {
+                RecordedPacket recorded;
+                recorded.data.assign(packet, packet + size);
+                recorded.sentBefore = session.sentDejavus.size();
+                session.received.push_back(recorded);
+            });
+        }
+    }
+    fclose(f);
+    gReplaying = true;
+    return true;
+}
+
+bool isCaptureReplaying()
+{
+    return gReplaying;
+}
+
+std::shared_ptr<ReplaySession> replayOpen(const char* nodeIp, int nodePort)
+{
+    std::lock_guard<std::mutex> guard(gCaptureLock);
+    auto it = gReplaySessions.find(nodeKey(nodeIp, nodePort));
+    if (it == gReplaySessions.end() || it->second.empty()) return nullptr;
+    std::shared_ptr<ReplaySession> session(new ReplaySession(it->second.front()));
+    it->second.pop_front();
+    return session;
+}
+
+int replaySend(ReplaySession& session, const uint8_t* buffer, int size)
+{
+    return session.send(buffer, size);
+}
+
+int replayRecv(ReplaySession& session, uint8_t* buffer, int size)
+{
+    return session.recv(buffer, size);
+}
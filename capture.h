@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+// Capture file: "QCAP" + uint32 version, then one CaptureRecord per event followed by `length` bytes.
+// CAPTURE_CONNECT carries "ip:port" of the node, the other events carry the raw bytes as they went
+// through the socket (a received chunk is not necessarily a whole packet).
+#define CAPTURE_MAGIC "QCAP"
+#define CAPTURE_VERSION 1
+
+enum CaptureDirection
+{
+    CAPTURE_CONNECT = 0,
+    CAPTURE_SENT = 1,
+    CAPTURE_RECEIVED = 2,
+};
+
+#pragma pack(push, 1)
+struct CaptureRecord
+{
+    uint64_t timestampUs;  // since the recording started
+    uint32_t connectionId; // one id per socket session, reconnects get a new one
+    uint8_t direction;     // CaptureDirection
+    uint32_t length;
+};
+#pragma pack(pop)
+
+// Records every socket session of QubicConnection to fileName, returns false if it cannot be created
+bool startCaptureRecording(const char* fileName);
+bool isCaptureRecording();
+// Returns the id of a new session, to be passed to captureWrite
+uint32_t captureOpen(const char* nodeIp, int nodePort);
+void captureWrite(uint32_t connectionId, CaptureDirection direction, const uint8_t* data, uint32_t length);
+
+// Makes QubicConnection replay fileName instead of opening sockets, returns false if it is not a capture
+bool startCaptureReplay(const char* fileName);
+bool isCaptureReplaying();
+
+// One recorded session, handed out to the sessions opened during the replay in the order they
+// were recorded for the same ip:port. Answers are released once as many requests have been sent
+// as before they were received, and their dejavus are mapped to the ones of the live requests.
+class ReplaySession;
+// nullptr if no more sessions to nodeIp:nodePort were recorded
+std::shared_ptr<ReplaySession> replayOpen(const char* nodeIp, int nodePort);
+int replaySend(ReplaySession& session, const uint8_t* buffer, int size);
+// Returns -1 (like a socket timeout) when nothing more was received at this point of the session
+int replayRecv(ReplaySession& session, uint8_t* buffer, int size);
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include "computorCache.h"
+#include "K12AndKeyUtil.h"
+#include "keyUtils.h"
+
+namespace
+{
+    std::mutex gCacheLock;
+    std::map<uint16_t, ComputorListPtr> gCache; // by epoch
+
+    ComputorListPtr buildComputorList(const BroadcastComputors& bc)
+    {
+        std::shared_ptr<ComputorList> list(new ComputorList);
+        list->bc = bc;
+        uint8_t digest[32] = {0};
+        uint8_t arbPubkey[32] = {0};
+        getPublicKeyFromIdentity(ARBITRATOR, arbPubkey);
+        KangarooTwelve(reinterpret_cast<const uint8_t *>(&bc),
+                       sizeof(BroadcastComputors) - SIGNATURE_SIZE,
+                       digest,
+                       32);
+        list->arbitratorSigned = verify(arbPubkey, digest, bc.computors.signature);
+        list->keyTableBytes.resize(NUMBER_OF_COMPUTORS * VERIFY_TABLE_SIZE + 31);
+        for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+        {
+            uint8_t* table = const_cast<uint8_t*>(list->keyTable(i));
+            // decoding loads the key 32 bytes at a time, the keys of the packed struct are not aligned for that
+            alignas(32) uint8_t publicKey[32];
+            memcpy(publicKey, bc.computors.publicKeys[i], 32);
+            list->keyValid[i] = buildVerifyTable(publicKey, table);
+        }
+        return list;
+    }
+}
+
+const uint8_t* ComputorList::keyTable(unsigned int computorIndex) const
+{
+    uintptr_t first = (reinterpret_cast<uintptr_t>(keyTableBytes.data()) + 31) & ~uintptr_t(31);
+    return reinterpret_cast<const uint8_t*>(first) + size_t(computorIndex) * VERIFY_TABLE_SIZE;
+}
+
+ComputorListPtr getComputorList(const BroadcastComputors& bc)
+{
+    {
+        std::lock_guard<std::mutex> lock(gCacheLock);
+        auto it = gCache.find(bc.computors.epoch);
+        if (it != gCache.end() && memcmp(&it->second->bc, &bc, sizeof(BroadcastComputors)) == 0) return it->second;
+    }
+    // building the tables takes a while, other epochs stay available meanwhile
+    ComputorListPtr list = buildComputorList(bc);
+    std::lock_guard<std::mutex> lock(gCacheLock);
+    gCache[bc.computors.epoch] = list;
+    return list;
+}
+
+ComputorListPtr loadComputorList(const char* fileName)
+{
+    std::unique_ptr<BroadcastComputors> bc(new BroadcastComputors);
+    FILE* f = fopen(fileName, "rb");
+    if (f == nullptr) return nullptr;
+    size_t read = fread(bc.get(), 1, sizeof(BroadcastComputors), f);
+    fclose(f);
+    if (read != sizeof(BroadcastComputors)) return nullptr;
+    return getComputorList(*bc);
+}
+
+bool verifyComputorSignature(const ComputorList& computors, unsigned int computorIndex, const uint8_t* digest,
+                             const uint8_t* signature)
+{
+    if (computorIndex >= NUMBER_OF_COMPUTORS || !computors.keyValid[computorIndex])
+    {
+        return false;
+    }
+    return verifyWithTable(computors.keyTable(computorIndex), computors.publicKey(computorIndex), digest, signature);
+}
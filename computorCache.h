@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "structs.h"
+
+// Computor list of one epoch, checked against the arbitrator signature and with a verification table built once
+// per public key, so that signatures of computors are checked without decoding their key or precomputing again
+struct ComputorList
+{
+    BroadcastComputors bc;
+    bool arbitratorSigned;
+    bool keyValid[NUMBER_OF_COMPUTORS];        // the public key decodes to a curve point
+    std::vector<uint8_t> keyTableBytes;        // buildVerifyTable() of each public key, see keyTable()
+    uint16_t epoch() const { return bc.computors.epoch; }
+    const uint8_t* publicKey(unsigned int computorIndex) const { return bc.computors.publicKeys[computorIndex]; }
+    // The table of computorIndex, VERIFY_TABLE_SIZE bytes. Tables must be 32 byte aligned, keyTableBytes has 31 bytes
+    // more than the tables need so that the first one starts on such a boundary
+    const uint8_t* keyTable(unsigned int computorIndex) const;
+};
+typedef std::shared_ptr<const ComputorList> ComputorListPtr;
+
+// The ComputorList of bc. Lists are cached by epoch, the arbitrator signature is checked and the tables are built
+// only the first time a list is seen (a different list for a cached epoch replaces it). Thread safe
+ComputorListPtr getComputorList(const BroadcastComputors& bc);
+// Same for the list of a -getcomputorlist file, nullptr if it can not be read
+ComputorListPtr loadComputorList(const char* fileName);
+
+// Same result as verify() with the public key of computorIndex, false for an index out of range
+bool verifyComputorSignature(const ComputorList& computors, unsigned int computorIndex, const uint8_t* digest,
+                             const uint8_t* signature);
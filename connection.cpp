@@ -5,15 +5,27 @@
 #include <Winsock2.h>
 #include <Ws2tcpip.h>
 #define close(x) closesocket(x)
+#define MSG_NOSIGNAL 0
 #else
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <sys/select.h>
 #endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS, SIGPIPE is not an issue for short lived cli runs
+#endif
+#include <algorithm>
 #include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
 
 #include "connection.h"
+#include "capture.h"
+#include "nodeRouter.h"
 #include "logger.h"
 #ifdef _MSC_VER
 static int connect(const char* nodeIp, int nodePort)
@@ -72,24 +84,112 @@ QubicConnection::QubicConnection(const char* nodeIp, int nodePort)
 	memset(mNodeIp, 0, 32);
 	memcpy(mNodeIp, nodeIp, strlen(nodeIp));
 	mNodePort = nodePort;
-	mSocket = connect(nodeIp, nodePort);
+    mLastDejavu = 0;
+    mSocket = -1;
+    mCaptureId = 0;
+    mRouted = false;
+    open();
+}
+QubicConnection::~QubicConnection()
+{
+    closeSession();
+}
+
+void QubicConnection::open()
+{
+    if (isCaptureReplaying())
+    {
+        mReplay = replayOpen(mNodeIp, mNodePort);
+        if (!mReplay)
+            throw std::logic_error("No connection.");
+        return;
+    }
+    mSocket = connect(mNodeIp, mNodePort);
     if (mSocket < 0)
         throw std::logic_error("No connection.");
+    if (isCaptureRecording()) mCaptureId = captureOpen(mNodeIp, mNodePort);
 }
-QubicConnection::~QubicConnection()
+
+void QubicConnection::closeSession()
+{
+    if (mSocket >= 0) close(mSocket);
+    mSocket = -1;
+    mReplay.reset();
+}
+
+void QubicConnection::reconnect()
+{
+    closeSession();
+    try
+    {
+        open();
+    }
+    catch (std::logic_error&)
+    {
+        // the node went away in the middle of a request, a routed one is replaced
+        NodeAddress next;
+        if (!mRouted || !failOverRoutedNode(mNodeIp, mNodePort, next)) throw;
+        memset(mNodeIp, 0, sizeof(mNodeIp));
+        memcpy(mNodeIp, next.ip.c_str(), std::min(next.ip.size(), sizeof(mNodeIp) - 1));
+        mNodePort = next.port;
+        open();
+    }
+}
+
+bool QubicConnection::isAlive()
 {
-	close(mSocket);
+    if (mReplay) return true;
+    if (mSocket < 0) return false;
+    uint8_t tmp[1024];
+    while (true)
+    {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(mSocket, &readSet);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+        int ready = select(mSocket + 1, &readSet, nullptr, nullptr, &tv);
+        if (ready < 0) return false;
+        if (ready == 0) return true; // nothing pending, the session is idle and open
+        // readable without blocking: either stale data or EOF/reset
+        int recvByte = recv(mSocket, (char*)tmp, sizeof(tmp), 0);
+        if (recvByte <= 0) return false;
+        if (mCaptureId) captureWrite(mCaptureId, CAPTURE_RECEIVED, tmp, recvByte);
+    }
+}
+
+bool QubicConnection::resendLastRequest()
+{
+    if (mLastRequest.empty()) return false;
+    try
+    {
+        reconnect();
+    }
+    catch (std::logic_error&)
+    {
+        return false;
+    }
+    return sendOnce(mLastRequest.data(), int(mLastRequest.size())) == int(mLastRequest.size());
 }
 
 int QubicConnection::receiveData(uint8_t* buffer, int sz)
 {
-	return recv(mSocket, (char*)buffer, sz, 0);
+    if (mReplay) return replayRecv(*mReplay, buffer, sz);
+	int recvByte = recv(mSocket, (char*)buffer, sz, 0);
+    if (mCaptureId && recvByte > 0) captureWrite(mCaptureId, CAPTURE_RECEIVED, buffer, recvByte);
+    return recvByte;
 }
 void QubicConnection::receiveDataAll(std::vector<uint8_t>& receivedData)
 {
     receivedData.resize(0);
     uint8_t tmp[1024];
     int recvByte = receiveData(tmp, 1024);
+    if (recvByte == 0 && resendLastRequest())
+    {
+        // the node had closed this (pooled) session before our request got there
+        recvByte = receiveData(tmp, 1024);
+    }
     while (recvByte > 0)
     {
         receivedData.resize(recvByte + receivedData.size());
@@ -102,33 +202,155 @@ void QubicConnection::receiveDataAll(std::vector<uint8_t>& receivedData)
     }
 }
 
+uint8_t* ReceiveBuffer::prepare(size_t minFree)
+{
+    if (mCapacity - mEnd >= minFree) return mData.get() + mEnd;
+    size_t live = mEnd - mBegin;
+    if (mBegin && mCapacity - live >= minFree)
+    {
+        memmove(mData.get(), mData.get() + mBegin, live);
+    }
+    else
+    {
+        size_t capacity = mCapacity ? mCapacity : 65536;
+        while (capacity - live < minFree) capacity *= 2;
+        std::unique_ptr<uint8_t[]> data(new uint8_t[capacity]);
+        if (live) memcpy(data.get(), mData.get() + mBegin, live);
+        mData.swap(data);
+        mCapacity = capacity;
+    }
+    mBegin = 0;
+    mEnd = live;
+    return mData.get() + mEnd;
+}
+
+void ReceiveBuffer::consume(size_t n)
+{
+    mBegin += n;
+    if (mBegin >= mEnd) mBegin = mEnd = 0;
+}
+
+void ReceiveBuffer::erase(size_t offset, size_t n)
+{
+    uint8_t* dst = mData.get() + mBegin + offset;
+    memmove(dst, dst + n, size() - offset - n);
+    mEnd -= n;
+}
+
+std::vector<PacketView> splitPackets(const uint8_t* data, size_t size)
+{
+    std::vector<PacketView> packets;
+    size_t ptr = 0;
+    while (size - ptr >= sizeof(RequestResponseHeader))
+    {
+        auto header = (RequestResponseHeader*)(data + ptr);
+        size_t packetSize = header->size();
+        if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX || size - ptr < packetSize)
+        {
+            break;
+        }
+        packets.push_back(PacketView(data + ptr, packetSize));
+        ptr += packetSize;
+    }
+    return packets;
+}
+
+void QubicConnection::receiveDataUntil(std::vector<uint8_t>& receivedData, std::initializer_list<uint8_t> stopTypes)
+{
+    ReceiveBuffer buffer;
+    try
+    {
+        receiveDataUntil(buffer, stopTypes);
+    }
+    catch (std::logic_error&)
+    {
+        receivedData.resize(0);
+        throw;
+    }
+    receivedData.assign(buffer.data(), buffer.data() + buffer.size());
+}
+
+void QubicConnection::receiveDataUntil(ReceiveBuffer& receivedData, std::initializer_list<uint8_t> stopTypes)
+{
+    const size_t chunkSize = 65536;
+    auto receiveChunk = [&]()
+    {
+        uint8_t* dst = receivedData.prepare(chunkSize);
+        return receiveData(dst, int(receivedData.freeSpace()));
+    };
+    receivedData.clear();
+    size_t ptr = 0; // offset of the first packet that has not been completely received yet
+    int recvByte = receiveChunk();
+    if (recvByte == 0 && resendLastRequest())
+    {
+        // the node had closed this (pooled) session before our request got there
+        recvByte = receiveChunk();
+    }
+    while (recvByte > 0)
+    {
+        receivedData.commit(recvByte);
+        while (receivedData.size() - ptr >= sizeof(RequestResponseHeader))
+        {
+            auto header = (RequestResponseHeader*)(receivedData.data() + ptr);
+            size_t packetSize = header->size();
+            if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+            {
+                // broken framing, nothing after this point can be parsed anyway
+                return;
+            }
+            if (receivedData.size() - ptr < packetSize)
+            {
+                // make sure the rest of this packet fits without growing again
+                receivedData.prepare(packetSize - (receivedData.size() - ptr));
+                break;
+            }
+            // responses echo the dejavu of the request, leftovers of an earlier request on a reused
+            // connection are dropped so that callers parsing by type do not pick them up
+            if (mLastDejavu != 0 && header->dejavu() != mLastDejavu
+                && !(header->dejavu() == 0 && header->type() == EXCHANGE_PUBLIC_PEERS))
+            {
+                receivedData.erase(ptr, packetSize);
+                continue;
+            }
+            for (uint8_t type : stopTypes)
+            {
+                if (header->type() == type)
+                {
+                    return;
+                }
+            }
+            ptr += packetSize;
+        }
+        recvByte = receiveChunk();
+    }
+    if (receivedData.size() == 0)
+    {
+        throw std::logic_error("Error: Did not receive any response from node.");
+    }
+}
+
 template <typename T>
 T QubicConnection::receivePacketAs()
 {
-    std::vector<uint8_t> receivedData;
-    receivedData.resize(0);
-    uint8_t tmp[1024];
-    int recvByte = receiveData(tmp, 1024);
-    while (recvByte > 0)
+    ReceiveBuffer receivedData;
+    try
     {
-        receivedData.resize(recvByte + receivedData.size());
-        memcpy(receivedData.data() + receivedData.size() - recvByte, tmp, recvByte);
-        recvByte = receiveData(tmp, 1024);
+        receiveDataUntil(receivedData, {T::type()});
+    }
+    catch (std::logic_error&)
+    {
+        // no response is a valid outcome here, callers check the zeroed result
     }
 
-    recvByte = receivedData.size();
-    uint8_t* data = receivedData.data();
-    int ptr = 0;
     T result;
     memset(&result, 0, sizeof(T));
-    while (ptr < recvByte)
+    for (auto& packet : splitPackets(receivedData.data(), receivedData.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == T::type()){
-            auto dataT = (T*)(data + ptr + sizeof(RequestResponseHeader));
+        const T* dataT = packet.type() == T::type() ? packet.as<T>() : nullptr;
+        if (dataT)
+        {
             result = *dataT;
         }
-        ptr+= header->size();
     }
     return result;
 }
@@ -136,40 +358,37 @@ T QubicConnection::receivePacketAs()
 template <typename T>
 std::vector<T> QubicConnection::getLatestVectorPacketAs()
 {
-    std::vector<uint8_t> receivedData;
-    receivedData.resize(0);
-    uint8_t tmp[1024];
-    int recvByte = receiveData(tmp, 1024);
-    while (recvByte > 0)
+    ReceiveBuffer receivedData;
+    try
     {
-        receivedData.resize(recvByte + receivedData.size());
-        memcpy(receivedData.data() + receivedData.size() - recvByte, tmp, recvByte);
-        recvByte = receiveData(tmp, 1024);
+        receiveDataUntil(receivedData, {END_RESPONSE});
+    }
+    catch (std::logic_error&)
+    {
+        // no response is a valid outcome here, callers check the vector size
     }
 
-    recvByte = receivedData.size();
-    uint8_t* data = receivedData.data();
-    int ptr = 0;
     std::vector<T> results;
-    while (ptr < recvByte)
+    for (auto& packet : splitPackets(receivedData.data(), receivedData.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == T::type()){
-            auto dataT = (T*)(data + ptr + sizeof(RequestResponseHeader));
+        const T* dataT = packet.type() == T::type() ? packet.as<T>() : nullptr;
+        if (dataT)
+        {
             results.push_back(*dataT);
         }
-        ptr+= header->size();
     }
     return results;
 }
 
-int QubicConnection::sendData(uint8_t* buffer, int sz)
+int QubicConnection::sendOnce(const uint8_t* buffer, int sz)
 {
+    if (mReplay) return replaySend(*mReplay, buffer, sz);
+    if (mCaptureId) captureWrite(mCaptureId, CAPTURE_SENT, buffer, sz);
     int size = sz;
     int numberOfBytes;
     while (size) {
-        if ((numberOfBytes = send(mSocket, (char*)buffer, size, 0)) <= 0) {
-            return 0;
+        if ((numberOfBytes = send(mSocket, (const char*)buffer, size, MSG_NOSIGNAL)) <= 0) {
+            break;
         }
         buffer += numberOfBytes;
         size -= numberOfBytes;
@@ -177,10 +396,245 @@ int QubicConnection::sendData(uint8_t* buffer, int sz)
 	return sz - size;
 }
 
+int QubicConnection::sendData(uint8_t* buffer, int sz)
+{
+    mLastRequest.assign(buffer, buffer + sz);
+    mLastDejavu = 0;
+    if (sz >= int(sizeof(RequestResponseHeader)))
+    {
+        mLastDejavu = ((RequestResponseHeader*)buffer)->dejavu();
+    }
+    int sent = sendOnce(buffer, sz);
+    if (sent != sz)
+    {
+        // broken pipe on a reused connection, start over on a fresh one
+        if (resendLastRequest()) return sz;
+        return 0;
+    }
+    return sent;
+}
+
+void QubicConnection::pipeline(std::vector<PipelineRequest>& requests, int maxInFlight)
+{
+    std::map<unsigned int, size_t> inFlight; // dejavu -> index of the request
+    std::deque<size_t> inFlightOrder;        // for answers that do not echo the dejavu
+    std::deque<size_t> toSend;
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        requests[i].response.clear();
+        requests[i].completed = false;
+        toSend.push_back(i);
+    }
+    if (maxInFlight < 1) maxInFlight = 1;
+    // requests of the batch are not repeated by resendLastRequest, a lost session is handled below
+    mLastRequest.clear();
+    mLastDejavu = 0;
+
+    size_t answered = 0;
+    size_t answeredAtReconnect = 0;
+    bool reconnected = false;
+    auto complete = [&](size_t index, bool ok)
+    {
+        auto& req = requests[index];
+        inFlight.erase(((RequestResponseHeader*)req.packet.data())->dejavu());
+        for (auto it = inFlightOrder.begin(); it != inFlightOrder.end(); it++)
+        {
+            if (*it == index)
+            {
+                inFlightOrder.erase(it);
+                break;
+            }
+        }
+        req.completed = ok;
+        answered++;
+    };
+    auto receive = [&](size_t index, const PacketView& packet)
+    {
+        auto& req = requests[index];
+        req.response.insert(req.response.end(), packet.payload(), packet.payload() + packet.payloadSize());
+        if (!req.multiPacket) complete(index, true);
+    };
+    ReceiveBuffer receivedData;
+    // The answers of everything in flight are lost with the session: they are queued again, ahead of the
+    // requests not sent yet, on a new session. A node that answers nothing between two lost sessions ends
+    // the batch, the requests left keep completed == false.
+    auto recover = [&]()
+    {
+        if (reconnected && answered == answeredAtReconnect) return false;
+        try
+        {
+            reconnect();
+        }
+        catch (std::logic_error&)
+        {
+            return false;
+        }
+        reconnected = true;
+        answeredAtReconnect = answered;
+        receivedData.clear();
+        for (auto it = inFlightOrder.rbegin(); it != inFlightOrder.rend(); it++)
+        {
+            requests[*it].response.clear();
+            toSend.push_front(*it);
+        }
+        inFlight.clear();
+        inFlightOrder.clear();
+        return true;
+    };
+
+    while (!toSend.empty() || !inFlight.empty())
+    {
+        bool lost = false;
+        while (!toSend.empty() && int(inFlight.size()) < maxInFlight)
+        {
+            size_t index = toSend.front();
+            auto& req = requests[index];
+            auto header = (RequestResponseHeader*)req.packet.data();
+            do
+            {
+                header->randomizeDejavu();
+            } while (inFlight.count(header->dejavu()));
+            if (sendOnce(req.packet.data(), int(req.packet.size())) != int(req.packet.size()))
+            {
+                lost = true;
+                break;
+            }
+            toSend.pop_front();
+            inFlight[header->dejavu()] = index;
+            inFlightOrder.push_back(index);
+        }
+
+        if (!lost)
+        {
+            uint8_t* dst = receivedData.prepare(65536);
+            int recvByte = receiveData(dst, int(receivedData.freeSpace()));
+            if (recvByte > 0)
+            {
+                receivedData.commit(recvByte);
+            }
+            else
+            {
+                // closed, or the node stopped answering within the timeout
+                lost = true;
+            }
+        }
+        if (lost)
+        {
+            if (!recover()) return;
+            continue;
+        }
+
+        size_t consumed = 0;
+        for (auto& packet : splitPackets(receivedData.data(), receivedData.size()))
+        {
+            consumed += packet.size();
+            auto it = inFlight.find(packet.dejavu());
+            if (it != inFlight.end())
+            {
+                size_t index = it->second;
+                if (packet.type() == requests[index].responseType)
+                {
+                    receive(index, packet);
+                }
+                else if (packet.type() == END_RESPONSE)
+                {
+                    complete(index, requests[index].multiPacket);
+                }
+            }
+            else
+            {
+                for (size_t index : inFlightOrder)
+                {
+                    if (requests[index].responseType == packet.type())
+                    {
+                        receive(index, packet);
+                        break;
+                    }
+                }
+            }
+        }
+        receivedData.consume(consumed);
+    }
+}
+
 template SpecialCommand QubicConnection::receivePacketAs<SpecialCommand>();
 template SpecialCommandToggleMainModeResquestAndResponse QubicConnection::receivePacketAs<SpecialCommandToggleMainModeResquestAndResponse>();
 template SpecialCommandSetSolutionThresholdResquestAndResponse QubicConnection::receivePacketAs<SpecialCommandSetSolutionThresholdResquestAndResponse>();
 template SpecialCommandSendTime QubicConnection::receivePacketAs<SpecialCommandSendTime>();
 template GetSendToManyV1Fee_output QubicConnection::receivePacketAs<GetSendToManyV1Fee_output>();
 
-template std::vector<Tick> QubicConnection::getLatestVectorPacketAs<Tick>();
\ No newline at end of file
+template std::vector<Tick> QubicConnection::getLatestVectorPacketAs<Tick>();
+
+namespace
+{
+    // Idle connections per "ip:port". A connection is owned by exactly one QCPtr while checked out.
+    struct ConnectionPool
+    {
+        std::mutex lock;
+        std::map<std::string, std::vector<QubicConnection*>> idle;
+        ~ConnectionPool()
+        {
+            for (auto& item : idle)
+            {
+                for (auto qc : item.second) delete qc;
+            }
+        }
+    };
+    const size_t MAX_IDLE_CONNECTIONS_PER_NODE = 8;
+
+    ConnectionPool& getConnectionPool()
+    {
+        static ConnectionPool pool;
+        return pool;
+    }
+
+    std::string poolKey(const char* nodeIp, int nodePort)
+    {
+        return std::string(nodeIp) + ":" + std::to_string(nodePort);
+    }
+
+    void releaseConnection(QubicConnection* qc)
+    {
+        auto& pool = getConnectionPool();
+        std::lock_guard<std::mutex> guard(pool.lock);
+        auto& idle = pool.idle[poolKey(qc->getNodeIp(), qc->getNodePort())];
+        if (idle.size() < MAX_IDLE_CONNECTIONS_PER_NODE)
+        {
+            idle.push_back(qc);
+            return;
+        }
+        delete qc;
+    }
+}
+
+QCPtr make_qc(const char* nodeIp, int nodePort)
+{
+    if (isRoutedNode(nodeIp, nodePort)) return makeRoutedConnection();
+    return makePooledConnection(nodeIp, nodePort);
+}
+
+QCPtr makePooledConnection(const char* nodeIp, int nodePort)
+{
+    auto& pool = getConnectionPool();
+    QubicConnection* qc = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(pool.lock);
+        auto& idle = pool.idle[poolKey(nodeIp, nodePort)];
+        while (!idle.empty() && !qc)
+        {
+            qc = idle.back();
+            idle.pop_back();
+            if (!qc->isAlive())
+            {
+                delete qc;
+                qc = nullptr;
+            }
+        }
+    }
+    if (!qc)
+    {
+        qc = new QubicConnection(nodeIp, nodePort);
+    }
+    qc->setRouted(false);
+    return QCPtr(qc, releaseConnection);
+}
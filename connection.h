@@ -2,6 +2,71 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <initializer_list>
+#include "structs.h"
+
+// Receive buffer that recv() writes into directly. It grows geometrically and only moves bytes when
+// consumed data is compacted away, so large responses are not copied chunk by chunk.
+class ReceiveBuffer
+{
+public:
+    ReceiveBuffer() : mCapacity(0), mBegin(0), mEnd(0) {}
+    // Returns room for at least minFree bytes after the current data
+    uint8_t* prepare(size_t minFree);
+    size_t freeSpace() const { return mCapacity - mEnd; }
+    void commit(size_t n) { mEnd += n; }
+    const uint8_t* data() const { return mData.get() + mBegin; }
+    size_t size() const { return mEnd - mBegin; }
+    void consume(size_t n);
+    // Removes n bytes starting offset bytes into the data, later bytes move up
+    void erase(size_t offset, size_t n);
+    void clear() { mBegin = mEnd = 0; }
+private:
+    ReceiveBuffer(const ReceiveBuffer&);
+    ReceiveBuffer& operator=(const ReceiveBuffer&);
+    std::unique_ptr<uint8_t[]> mData;
+    size_t mCapacity;
+    size_t mBegin;
+    size_t mEnd;
+};
+
+// Bounds checked, non-owning view of one received packet
+class PacketView
+{
+public:
+    PacketView(const uint8_t* packet, size_t size) : mPacket(packet), mSize(size) {}
+    size_t size() const { return mSize; }
+    uint8_t type() const { return header()->type(); }
+    unsigned int dejavu() const { return header()->dejavu(); }
+    const uint8_t* payload() const { return mPacket + sizeof(RequestResponseHeader); }
+    size_t payloadSize() const { return mSize - sizeof(RequestResponseHeader); }
+    // The payload read in place as T, nullptr if fewer than minSize bytes were received
+    template <typename T> const T* as(size_t minSize = sizeof(T)) const
+    {
+        return payloadSize() >= minSize ? (const T*)payload() : nullptr;
+    }
+private:
+    RequestResponseHeader* header() const { return (RequestResponseHeader*)mPacket; }
+    const uint8_t* mPacket;
+    size_t mSize;
+};
+
+// Splits received bytes into complete packets, stops at the first truncated or broken one
+std::vector<PacketView> splitPackets(const uint8_t* data, size_t size);
+// One request of a batch sent through QubicConnection::pipeline
+struct PipelineRequest
+{
+    std::vector<uint8_t> packet;   // complete packet starting with RequestResponseHeader
+    uint8_t responseType;          // type of the packet that answers this request
+    bool multiPacket;              // answered by any number of responseType packets followed by END_RESPONSE
+    std::vector<uint8_t> response; // payload of the answer, without header. Payloads of all packets one after
+                                   // the other for multiPacket requests
+    bool completed;                // false if the node did not answer (or answered with END_RESPONSE only,
+                                   // unless multiPacket)
+};
+
+class ReplaySession;
+
 // Not thread safe
 class QubicConnection
 {
@@ -11,15 +76,49 @@ public:
 	int receiveData(uint8_t* buffer, int sz);
 	int sendData(uint8_t* buffer, int sz);
     void receiveDataAll(std::vector<uint8_t>& buffer);
+    // Reads framed packets and returns as soon as a packet of one of stopTypes has fully arrived,
+    // instead of waiting for the socket timeout. Falls back to the timeout if it never comes.
+    // Answers to earlier requests (another dejavu than the last one sent) are dropped, of the packets
+    // the node sends on its own (dejavu 0) only peer announcements are kept.
+    void receiveDataUntil(std::vector<uint8_t>& buffer, std::initializer_list<uint8_t> stopTypes);
+    // Same as above without intermediate copies, read the packets in place with splitPackets
+    void receiveDataUntil(ReceiveBuffer& buffer, std::initializer_list<uint8_t> stopTypes);
     template <typename T> T receivePacketAs();
     template <typename T> std::vector<T> getLatestVectorPacketAs();
+    // Sends all requests back-to-back, keeping up to maxInFlight of them outstanding, and routes
+    // every answer to its request by the echoed dejavu (falling back to type + request order).
+    // Dejavus of the packets are overwritten with unique values. If the session is lost (closed, failed
+    // send, no answer within the socket timeout) everything not answered yet is sent again on a new one.
+    void pipeline(std::vector<PipelineRequest>& requests, int maxInFlight = 32);
+    // Health check for an idle connection: false if the node closed it.
+    // Leftover bytes of earlier responses are discarded.
+    bool isAlive();
+    // Closes the socket and connects again to the same node, throws on failure. A routed connection
+    // (see nodeRouter.h) that can not reach its node again moves on to the next best node instead
+    void reconnect();
+    void setRouted(bool routed) { mRouted = routed; }
+    const char* getNodeIp() const { return mNodeIp; }
+    int getNodePort() const { return mNodePort; }
 private:
+    // Opens the socket, or the next recorded session when a capture is replayed
+    void open();
+    void closeSession();
+    int sendOnce(const uint8_t* buffer, int sz);
+    bool resendLastRequest();
 	char mNodeIp[32];
 	int mNodePort;
 	int mSocket;
+    uint32_t mCaptureId; // session id in the capture file being recorded, 0 if not recording
+    std::shared_ptr<ReplaySession> mReplay;
+    std::vector<uint8_t> mLastRequest; // kept to repeat it once if the node dropped the connection
+    unsigned int mLastDejavu;
+    bool mRouted;
 };
 typedef std::shared_ptr<QubicConnection> QCPtr;
-static QCPtr make_qc(const char* nodeIp, int nodePort)
-{
-    return std::make_shared<QubicConnection>(nodeIp, nodePort);
-}
\ No newline at end of file
+// Returns a connection to nodeIp:nodePort from the process wide pool, opening a new one only
+// if no idle session to that node is available. The connection goes back to the pool when the
+// last QCPtr to it is released, so hold on to it instead of calling make_qc again in nested helpers.
+// With -nodelist, requests for the routed node go to the best node of the list instead (see nodeRouter.h).
+QCPtr make_qc(const char* nodeIp, int nodePort);
+// make_qc without routing
+QCPtr makePooledConnection(const char* nodeIp, int nodePort);
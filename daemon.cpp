@@ -0,0 +1,480 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "daemon.h"
+#include "logger.h"
+#ifndef _MSC_VER
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is ignored while the daemon runs
+#endif
+#define DAEMON_MAX_REQUEST_SIZE (1 << 20)
+#define DAEMON_MAX_CLIENTS 64 // connections served at once, more are closed right away
+
+static thread_local bool gInRequest = false;
+// commands share the globals and stdout, every connection has its own thread but commands run one at a time
+static std::mutex gRequestLock;
+static std::atomic<int> gClients(0);
+
+void cliExit(int code)
+{
+    if (gInRequest) throw CliExit{code};
+    fflush(stdout);
+    exit(code);
+}
+
+// Rejects the commands that only make sense once per process, and the ones that never return: requests
+// run one after the other, so they would block every later one
+static bool isNestedCommand(const std::vector<std::string>& args, std::string& error)
+{
+    for (auto& arg : args)
+    {
+        if (arg == "-daemon" || arg == "-batch")
+        {
+            error = arg + " is not accepted in a request\n";
+            return true;
+        }
+        if (arg == "-followticks" || arg == "-archiveticks")
+        {
+            error = arg + " does not end, it is not accepted in a request\n";
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs "qubic-cli <baseArgs> <args>", a failed check or a thrown error ends only this command
+static int runArguments(const std::vector<std::string>& baseArgs, const std::vector<std::string>& args,
+                        int (*runCommand)(int argc, char* argv[]))
+{
+    std::vector<std::string> all;
+    all.push_back("qubic-cli");
+    all.insert(all.end(), baseArgs.begin(), baseArgs.end());
+    all.insert(all.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (auto& arg : all) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+
+    int status = 0;
+    gInRequest = true;
+    try
+    {
+        status = runCommand(int(all.size()), argv.data());
+    }
+    catch (CliExit& e)
+    {
+        status = e.code;
+    }
+    catch (std::exception& e)
+    {
+        LOG("%s\n", e.what());
+        status = -1;
+    }
+    gInRequest = false;
+    return status;
+}
+
+// Splits a batch line like a shell would for simple cases: blanks separate arguments, double quotes group them
+static std::vector<std::string> splitBatchLine(const std::string& line)
+{
+    std::vector<std::string> args;
+    std::string arg;
+    bool quoted = false, inArg = false;
+    for (char c : line)
+    {
+        if (c == '"')
+        {
+            quoted = !quoted;
+            inArg = true;
+        }
+        else if (!quoted && (c == ' ' || c == '\t' || c == '\r' || c == '\n'))
+        {
+            if (inArg) args.push_back(arg);
+            arg.clear();
+            inArg = false;
+        }
+        else
+        {
+            arg += c;
+            inArg = true;
+        }
+    }
+    if (inArg) args.push_back(arg);
+    return args;
+}
+
+int runBatch(const char* fileName, const std::vector<std::string>& baseArgs, int jobs, int (*runCommand)(int argc, char* argv[]))
+{
+    FILE* f = fopen(fileName, "r");
+    if (f == nullptr)
+    {
+        LOG("Failed to open %s\n", fileName);
+        return 1;
+    }
+    std::vector<std::vector<std::string>> commands;
+    std::vector<int> lineNumbers;
+    std::string line;
+    int lineNumber = 0;
+    char chunk[1024];
+    while (fgets(chunk, sizeof(chunk), f))
+    {
+        line += chunk;
+        if (line.back() != '\n' && !feof(f)) continue;
+        lineNumber++;
+        auto args = splitBatchLine(line);
+        line.clear();
+        if (args.empty() || args[0][0] == '#') continue;
+        commands.push_back(args);
+        lineNumbers.push_back(lineNumber);
+    }
+    fclose(f);
+
+    std::vector<int> statuses(commands.size(), 0);
+    std::vector<std::string> outputs(commands.size());
+    std::vector<bool> done(commands.size(), false);
+    std::mutex lock;
+    std::condition_variable finished;
+    std::atomic<size_t> next(0);
+    auto worker = [&](bool capture)
+    {
+        for (size_t i = next++; i < commands.size(); i = next++)
+        {
+            std::string output;
+            int status;
+            if (capture) logCaptureBuffer() = &output;
+            if (isNestedCommand(commands[i], output))
+            {
+                status = 1;
+                if (!capture) LOG("%s", output.c_str());
+            }
+            else
+            {
+                status = runArguments(baseArgs, commands[i], runCommand);
+            }
+            logCaptureBuffer() = nullptr;
+            std::lock_guard<std::mutex> guard(lock);
+            statuses[i] = status;
+            outputs[i].swap(output);
+            done[i] = true;
+            finished.notify_all();
+        }
+    };
+
+    int failed = 0;
+    if (jobs <= 1)
+    {
+        // output is printed as it comes
+        worker(false);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < jobs && t < int(commands.size()); t++) workers.emplace_back(worker, true);
+        // the output of each command is printed in file order as soon as the ones before it are done
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [&]() { return bool(done[i]); });
+            std::string output;
+            output.swap(outputs[i]);
+            guard.unlock();
+            fwrite(output.data(), 1, output.size(), stdout);
+        }
+        for (auto& thread : workers) thread.join();
+    }
+    for (size_t i = 0; i < commands.size(); i++)
+    {
+        if (statuses[i] == 0) continue;
+        LOG("Line %d failed with status %d\n", lineNumbers[i], statuses[i]);
+        failed++;
+    }
+    LOG("Batch: %d commands, %d failed\n", int(commands.size()), failed);
+    return failed ? 1 : 0;
+}
+
+#ifdef _MSC_VER
+int runDaemon(const char* socketPath, const std::vector<std::string>& baseArgs, int (*runCommand)(int argc, char* argv[]))
+{
+    LOG("-daemon is not supported on Windows\n");
+    return -1;
+}
+#else
+static bool readAll(int fd, void* buffer, size_t size)
+{
+    uint8_t* ptr = (uint8_t*)buffer;
+    while (size)
+    {
+        ssize_t n = read(fd, ptr, size);
+        if (n <= 0) return false;
+        ptr += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const void* buffer, size_t size)
+{
+    const uint8_t* ptr = (const uint8_t*)buffer;
+    while (size)
+    {
+        ssize_t n = send(fd, ptr, size, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        ptr += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Parses the strings of the "args" array, only what a request needs of JSON
+static bool parseJsonArgs(const std::string& json, std::vector<std::string>& args)
+{
+    size_t pos = json.find("\"args\"");
+    if (pos == std::string::npos) return false;
+    pos = json.find('[', pos);
+    if (pos == std::string::npos) return false;
+    pos++;
+    while (pos < json.size())
+    {
+        char c = json[pos];
+        if (c == ']') return true;
+        if (c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n')
+        {
+            pos++;
+            continue;
+        }
+        if (c != '"') return false;
+        std::string arg;
+        pos++;
+        while (pos < json.size() && json[pos] != '"')
+        {
+            if (json[pos] == '\\' && pos + 1 < json.size())
+            {
+                pos++;
+                switch (json[pos])
+                {
+                    case 'n': arg += '\n'; break;
+                    case 't': arg += '\t'; break;
+                    case 'r': arg += '\r'; break;
+                    case 'u':
+                        if (pos + 4 >= json.size()) return false;
+                        arg += char(strtol(json.substr(pos + 1, 4).c_str(), nullptr, 16));
+                        pos += 4;
+                        break;
+                    default: arg += json[pos]; break;
+                }
+            }
+            else
+            {
+                arg += json[pos];
+            }
+            pos++;
+        }
+        if (pos >= json.size()) return false;
+        args.push_back(arg);
+        pos++;
+    }
+    return false;
+}
+
+static std::string jsonEscape(const std::string& text)
+{
+    std::string out;
+    for (unsigned char c : text)
+    {
+        if (c == '"') out += "\\\"";
+        else if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '\t') out += "\\t";
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else out += char(c);
+    }
+    return out;
+}
+
+// Runs one command with stdout redirected to a temporary file, so everything it prints is answered
+static int executeRequest(const std::vector<std::string>& baseArgs, const std::vector<std::string>& args,
+                          int (*runCommand)(int argc, char* argv[]), std::string& output)
+{
+    if (isNestedCommand(args, output)) return 1;
+
+    FILE* capture = tmpfile();
+    if (capture == nullptr)
+    {
+        output = "Failed to capture the output\n";
+        return -1;
+    }
+    fflush(stdout);
+    int savedStdout = dup(1);
+    dup2(fileno(capture), 1);
+    int status = runArguments(baseArgs, args, runCommand);
+    fflush(stdout);
+    dup2(savedStdout, 1);
+    close(savedStdout);
+
+    output.clear();
+    rewind(capture);
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), capture)) > 0) output.append(buffer, n);
+    fclose(capture);
+    return status;
+}
+
+static void serveClient(int fd, const std::vector<std::string>& baseArgs, int (*runCommand)(int argc, char* argv[]))
+{
+    while (true)
+    {
+        uint8_t first;
+        if (!readAll(fd, &first, 1)) return;
+        std::vector<std::string> args;
+        bool json = first == '{';
+        if (json)
+        {
+            std::string line(1, char(first));
+            char c;
+            while (readAll(fd, &c, 1) && c != '\n')
+            {
+                line += c;
+                if (line.size() > DAEMON_MAX_REQUEST_SIZE) return;
+            }
+            if (!parseJsonArgs(line, args))
+            {
+                std::string answer = "{\"status\":1,\"output\":\"invalid request\"}\n";
+                if (!writeAll(fd, answer.data(), answer.size())) return;
+                continue;
+            }
+        }
+        else
+        {
+            uint8_t lengthBytes[4] = {first};
+            if (!readAll(fd, lengthBytes + 1, 3)) return;
+            uint32_t length;
+            memcpy(&length, lengthBytes, 4);
+            if (length > DAEMON_MAX_REQUEST_SIZE) return;
+            std::string body(length, '\0');
+            if (length && !readAll(fd, &body[0], length)) return;
+            size_t start = 0;
+            while (start < body.size())
+            {
+                size_t end = body.find('\0', start);
+                if (end == std::string::npos) end = body.size();
+                args.push_back(body.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+
+        std::string output;
+        int status;
+        {
+            std::lock_guard<std::mutex> lock(gRequestLock);
+            status = executeRequest(baseArgs, args, runCommand, output);
+        }
+        if (json)
+        {
+            std::string answer = "{\"status\":" + std::to_string(status) + ",\"output\":\"" + jsonEscape(output) + "\"}\n";
+            if (!writeAll(fd, answer.data(), answer.size())) return;
+        }
+        else
+        {
+            int32_t header[2] = {status, int32_t(output.size())};
+            if (!writeAll(fd, header, sizeof(header)) || !writeAll(fd, output.data(), output.size())) return;
+        }
+    }
+}
+
+int runDaemon(const char* socketPath, const std::vector<std::string>& baseArgs, int (*runCommand)(int argc, char* argv[]))
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        LOG("Socket path is too long: %s\n", socketPath);
+        return -1;
+    }
+    strcpy(addr.sun_path, socketPath);
+    signal(SIGPIPE, SIG_IGN);
+    // only a socket left behind by a daemon that is gone is replaced
+    struct stat existing;
+    if (lstat(socketPath, &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            LOG("%s exists and is not a socket\n", socketPath);
+            return -1;
+        }
+        int probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probeFd >= 0 && connect(probeFd, (sockaddr*)&addr, sizeof(addr)) == 0;
+        if (probeFd >= 0) close(probeFd);
+        if (live)
+        {
+            LOG("A daemon is already listening on %s\n", socketPath);
+            return -1;
+        }
+        unlink(socketPath);
+    }
+    int serverFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    // the daemon signs with the configured seed, only its user may talk to it. The socket is created
+    // without access for others, restricting it after bind() would leave a window open
+    mode_t savedUmask = umask(0077);
+    int bound = serverFd < 0 ? -1 : bind(serverFd, (sockaddr*)&addr, sizeof(addr));
+    umask(savedUmask);
+    if (bound < 0)
+    {
+        LOG("Failed to listen on %s\n", socketPath);
+        if (serverFd >= 0) close(serverFd);
+        return -1;
+    }
+    if (chmod(socketPath, 0600) != 0)
+    {
+        LOG("Failed to restrict access to %s\n", socketPath);
+        close(serverFd);
+        unlink(socketPath);
+        return -1;
+    }
+    if (listen(serverFd, 16) < 0)
+    {
+        LOG("Failed to listen on %s\n", socketPath);
+        close(serverFd);
+        unlink(socketPath);
+        return -1;
+    }
+    LOG("Daemon listening on %s\n", socketPath);
+    fflush(stdout);
+    while (true)
+    {
+        int fd = accept(serverFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (gClients >= DAEMON_MAX_CLIENTS)
+        {
+            close(fd);
+            continue;
+        }
+        // an idle client must not hold up the others. runDaemon never returns, so baseArgs outlives the threads
+        gClients++;
+        std::thread([fd, &baseArgs, runCommand]()
+        {
+            serveClient(fd, baseArgs, runCommand);
+            close(fd);
+            gClients--;
+        }).detach();
+    }
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Thrown by cliExit while a daemon request runs, so a failed check ends the request instead of the daemon
+struct CliExit
+{
+    int code;
+};
+
+// Replacement for exit() in command code: exits the process, or ends the current request in daemon and batch mode
+[[noreturn]] void cliExit(int code);
+
+// Serves commands on the Unix domain socket at socketPath until the process is killed. A socket left at socketPath
+// by a daemon that is gone is replaced, anything else there (a file, a running daemon) makes it fail.
+// A request is the argument list of one command (without the basic config, baseArgs are put in front of it):
+//  - binary: uint32 length, then the arguments each terminated by '\0'.
+//    Answer: int32 exit status, uint32 length, then the output of the command.
+//  - JSON: one line {"args":["-getbalance","ID"]}. Answer: one line {"status":0,"output":"..."}
+// The connection pool, the node router and the keys derived from seeds (getKeysFromSeed) stay warm between requests.
+// runCommand parses the arguments and runs the command. Every connection is served by its own thread (at most
+// DAEMON_MAX_CLIENTS), the commands themselves run one at a time.
+int runDaemon(const char* socketPath, const std::vector<std::string>& baseArgs, int (*runCommand)(int argc, char* argv[]));
+
+// Runs the commands of fileName, one per line with the same arguments as on the command line ('#' starts a comment),
+// with baseArgs put in front of each. With jobs > 1 that many commands run at once, the output of each one is still
+// printed in file order. Returns 1 if any command failed.
+int runBatch(const char* fileName, const std::vector<std::string>& baseArgs, int jobs, int (*runCommand)(int argc, char* argv[]));
@@ -20,6 +20,7 @@
 #define REQUEST_TICK_TRANSACTIONS 29
 #define REQUEST_ENTITY 31
 #define RESPOND_ENTITY 32
+#define END_RESPONSE 35 // sent by the node after the last packet of a multi-packet response
 #define PROCESS_SPECIAL_COMMAND 255
 #define REQUEST_ISSUED_ASSETS 36
 #define RESPOND_ISSUED_ASSETS 37
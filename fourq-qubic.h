@@ -9,11 +9,22 @@ typedef struct
 } point_affine;
 typedef point_affine point_t[1];
 
+#define VERIFY_TABLE_SIZE 4096 // bytes of a buildVerifyTable() table
+
 extern "C" {
 
 	void ecc_mul_fixed(unsigned long long* k, point_t Q);
 	void encode(point_t P, unsigned char* Pencoded);
 	void sign(const unsigned char* subSeed, const unsigned char* publicKey, const unsigned char* messageDigest, unsigned char* signature);
 	bool verify(const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature);
+	// Verifies count signatures one by one, item i being publicKeys + 32*i, messageDigests + 32*i and signatures + 64*i.
+	// Items sharing a public key decode it once and reuse a buildVerifyTable() table, there is no batch equation.
+	// results[i] is what verify() returns for item i, the return value tells whether all of them are valid
+	bool verifyGroupedByKey(const unsigned char* publicKeys, const unsigned char* messageDigests, const unsigned char* signatures, unsigned int count, bool* results);
+	// Fills table (VERIFY_TABLE_SIZE bytes, 32 byte aligned) with what verifyWithTable() needs for publicKey,
+	// false if publicKey is not a valid point
+	bool buildVerifyTable(const unsigned char* publicKey, unsigned char* table);
+	// verify() for a key whose table buildVerifyTable() has built (32 byte aligned), for keys that sign many messages
+	bool verifyWithTable(const unsigned char* table, const unsigned char* publicKey, const unsigned char* messageDigest, const unsigned char* signature);
 
 }
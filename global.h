@@ -1,70 +1,163 @@
 #include "defines.h"
-COMMAND g_cmd;
-char* g_seed = DEFAULT_SEED;
-char* g_nodeIp = DEFAULT_NODE_IP;
-char* g_targetIdentity = nullptr;
-char* g_configFile = nullptr;
-char* g_requestedFileName = nullptr;
-char* g_requestedFileName2 = nullptr;
-char* g_requestedTxId  = nullptr;
-char* g_requestedIdentity  = nullptr;
-char* g_qx_share_transfer_possessed_identity = nullptr;
-char* g_qx_share_transfer_new_owner_identity = nullptr;
-int64_t g_qx_share_transfer_amount = 0;
+// thread_local: the workers of -batch -jobs each parse and run their own command
+thread_local COMMAND g_cmd;
+// writable copies of the defaults, g_seed and g_nodeIp point at them until a value is given
+thread_local char g_defaultSeed[] = DEFAULT_SEED;
+thread_local char g_defaultNodeIp[] = DEFAULT_NODE_IP;
+thread_local char* g_seed = g_defaultSeed;
+thread_local char* g_nodeIp = g_defaultNodeIp;
+thread_local char* g_nodeIps = nullptr; // comma separated, queries are fanned out to all of them when set
+thread_local char* g_fanoutPolicy = nullptr;
+thread_local char* g_nodeListFile = nullptr; // commands are routed to the best node of this list when set
+thread_local char* g_recordFile = nullptr; // capture of all node sessions is written there
+thread_local char* g_replayFile = nullptr; // node sessions are replayed from this capture instead of the network
+thread_local char* g_targetIdentity = nullptr;
+thread_local char* g_configFile = nullptr;
+thread_local char* g_requestedFileName = nullptr;
+thread_local char* g_requestedFileName2 = nullptr;
+thread_local char** g_requestedFiles = nullptr; // commands taking any number of files
+thread_local int g_requestedFileCount = 0;
+thread_local char* g_requestedTxId  = nullptr;
+thread_local char* g_requestedIdentity  = nullptr;
+thread_local char* g_qx_share_transfer_possessed_identity = nullptr;
+thread_local char* g_qx_share_transfer_new_owner_identity = nullptr;
+thread_local int64_t g_qx_share_transfer_amount = 0;
 
-int64_t g_TxAmount = 0;
-uint16_t g_TxType = 0;
-uint32_t g_TxTick = 0;
-int g_nodePort = DEFAULT_NODE_PORT;
-int g_txExtraDataSize = 0;
-int g_rawPacketSize = 0;
-int g_requestedSpecialCommand = -1;
-char* g_toogle_main_aux_0 = nullptr;
-char* g_toogle_main_aux_1 = nullptr;
-int g_set_solution_threshold_epoch = -1;
-int g_set_solution_threshold_value = -1;
+thread_local int64_t g_TxAmount = 0;
+thread_local uint16_t g_TxType = 0;
+thread_local uint32_t g_TxTick = 0;
+thread_local int g_nodePort = DEFAULT_NODE_PORT;
+thread_local int g_txExtraDataSize = 0;
+thread_local int g_rawPacketSize = 0;
+thread_local int g_requestedSpecialCommand = -1;
+thread_local char* g_toogle_main_aux_0 = nullptr;
+thread_local char* g_toogle_main_aux_1 = nullptr;
+thread_local int g_set_solution_threshold_epoch = -1;
+thread_local int g_set_solution_threshold_value = -1;
 
 
-uint32_t g_requestedTickNumber = 0;
-uint32_t g_offsetScheduledTick = DEFAULT_SCHEDULED_TICK_OFFSET;
-int g_waitUntilFinish = 0;
-uint8_t g_txExtraData[1024] = {0};
-uint8_t g_rawPacket[1024] = {0};
+thread_local uint32_t g_requestedTickNumber = 0;
+thread_local uint32_t g_requestedTickNumber2 = 0;
+thread_local int g_crawlDepth = 0;
+thread_local int g_crawlWidth = 0;
+thread_local int g_jobs = 1;
+thread_local int g_rateLimit = 0;
+thread_local uint32_t g_offsetScheduledTick = DEFAULT_SCHEDULED_TICK_OFFSET;
+thread_local int g_waitUntilFinish = 0;
+thread_local uint8_t g_txExtraData[1024] = {0};
+thread_local uint8_t g_rawPacket[1024] = {0};
 
-char* g_qx_issue_asset_name = nullptr;
-char* g_qx_issue_unit_of_measurement = nullptr;
-int64_t g_qx_issue_asset_number_of_unit = -1;
-char g_qx_issue_asset_num_decimal = 0;
+thread_local char* g_qx_issue_asset_name = nullptr;
+thread_local char* g_qx_issue_unit_of_measurement = nullptr;
+thread_local int64_t g_qx_issue_asset_number_of_unit = -1;
+thread_local char g_qx_issue_asset_num_decimal = 0;
 
-char* g_qx_command_1 = nullptr;
-char* g_qx_command_2 = nullptr;
-char* g_qx_issuer = nullptr;
-char* g_qx_asset_name = nullptr;
-long long g_qx_offset = -1;
-long long g_qx_price = -1;
-long long g_qx_number_of_share = -1;
+thread_local char* g_qx_command_1 = nullptr;
+thread_local char* g_qx_command_2 = nullptr;
+thread_local char* g_qx_issuer = nullptr;
+thread_local char* g_qx_asset_name = nullptr;
+thread_local long long g_qx_offset = -1;
+thread_local long long g_qx_price = -1;
+thread_local long long g_qx_number_of_share = -1;
 
-char* g_qx_asset_transfer_possessed_identity = nullptr;
-char* g_qx_asset_transfer_new_owner_identity = nullptr;
-int64_t g_qx_asset_transfer_amount = -1;
-char* g_qx_asset_transfer_asset_name;
-char* g_qx_asset_transfer_issuer_in_hex;
+thread_local char* g_qx_asset_transfer_possessed_identity = nullptr;
+thread_local char* g_qx_asset_transfer_new_owner_identity = nullptr;
+thread_local int64_t g_qx_asset_transfer_amount = -1;
+thread_local char* g_qx_asset_transfer_asset_name;
+thread_local char* g_qx_asset_transfer_issuer_in_hex;
 
-char* g_dump_binary_file_input;
-char* g_dump_binary_file_output;
+thread_local char* g_dump_binary_file_input;
+thread_local char* g_dump_binary_file_output;
 
 //IPO bid
-uint32_t g_ipo_contract_index = 0;
-uint16_t g_make_ipo_bid_number_of_share = 0;
-uint64_t g_make_ipo_bid_price_per_share = 0;
+thread_local uint32_t g_ipo_contract_index = 0;
+thread_local uint16_t g_make_ipo_bid_number_of_share = 0;
+thread_local uint64_t g_make_ipo_bid_price_per_share = 0;
 // quottery
-uint32_t g_quottery_bet_id;
-uint32_t g_quottery_option_id;
-char* g_quottery_creator_id = nullptr;
-uint64_t g_quottery_number_bet_slot;
-uint64_t g_quottery_amount_per_bet_slot;
-uint32_t g_quottery_picked_option;
+thread_local uint32_t g_quottery_bet_id;
+thread_local uint32_t g_quottery_option_id;
+thread_local char* g_quottery_creator_id = nullptr;
+thread_local uint64_t g_quottery_number_bet_slot;
+thread_local uint64_t g_quottery_amount_per_bet_slot;
+thread_local uint32_t g_quottery_picked_option;
 
-char* g_qutil_sendtomanyv1_payout_list_file = nullptr;
+thread_local char* g_qutil_sendtomanyv1_payout_list_file = nullptr;
 
-uint64_t g_get_log_passcode[4] = {0};
+thread_local uint64_t g_get_log_passcode[4] = {0};
+
+// Puts every global above back to its initial value, so that several commands can be parsed and run
+// in one process (-daemon, -batch). Keep it in sync when adding a global.
+static void resetGlobals()
+{
+    g_cmd = TOTAL_COMMAND;
+    strcpy(g_defaultSeed, DEFAULT_SEED);
+    strcpy(g_defaultNodeIp, DEFAULT_NODE_IP);
+    g_seed = g_defaultSeed;
+    g_nodeIp = g_defaultNodeIp;
+    g_nodeIps = nullptr;
+    g_fanoutPolicy = nullptr;
+    g_nodeListFile = nullptr;
+    g_recordFile = nullptr;
+    g_replayFile = nullptr;
+    g_targetIdentity = nullptr;
+    g_configFile = nullptr;
+    g_requestedFileName = nullptr;
+    g_requestedFileName2 = nullptr;
+    g_requestedFiles = nullptr;
+    g_requestedFileCount = 0;
+    g_requestedTxId = nullptr;
+    g_requestedIdentity = nullptr;
+    g_qx_share_transfer_possessed_identity = nullptr;
+    g_qx_share_transfer_new_owner_identity = nullptr;
+    g_qx_share_transfer_amount = 0;
+    g_TxAmount = 0;
+    g_TxType = 0;
+    g_TxTick = 0;
+    g_nodePort = DEFAULT_NODE_PORT;
+    g_txExtraDataSize = 0;
+    g_rawPacketSize = 0;
+    g_requestedSpecialCommand = -1;
+    g_toogle_main_aux_0 = nullptr;
+    g_toogle_main_aux_1 = nullptr;
+    g_set_solution_threshold_epoch = -1;
+    g_set_solution_threshold_value = -1;
+    g_requestedTickNumber = 0;
+    g_requestedTickNumber2 = 0;
+    g_crawlDepth = 0;
+    g_crawlWidth = 0;
+    g_jobs = 1;
+    g_rateLimit = 0;
+    g_offsetScheduledTick = DEFAULT_SCHEDULED_TICK_OFFSET;
+    g_waitUntilFinish = 0;
+    memset(g_txExtraData, 0, sizeof(g_txExtraData));
+    memset(g_rawPacket, 0, sizeof(g_rawPacket));
+    g_qx_issue_asset_name = nullptr;
+    g_qx_issue_unit_of_measurement = nullptr;
+    g_qx_issue_asset_number_of_unit = -1;
+    g_qx_issue_asset_num_decimal = 0;
+    g_qx_command_1 = nullptr;
+    g_qx_command_2 = nullptr;
+    g_qx_issuer = nullptr;
+    g_qx_asset_name = nullptr;
+    g_qx_offset = -1;
+    g_qx_price = -1;
+    g_qx_number_of_share = -1;
+    g_qx_asset_transfer_possessed_identity = nullptr;
+    g_qx_asset_transfer_new_owner_identity = nullptr;
+    g_qx_asset_transfer_amount = -1;
+    g_qx_asset_transfer_asset_name = nullptr;
+    g_qx_asset_transfer_issuer_in_hex = nullptr;
+    g_dump_binary_file_input = nullptr;
+    g_dump_binary_file_output = nullptr;
+    g_ipo_contract_index = 0;
+    g_make_ipo_bid_number_of_share = 0;
+    g_make_ipo_bid_price_per_share = 0;
+    g_quottery_bet_id = 0;
+    g_quottery_option_id = 0;
+    g_quottery_creator_id = nullptr;
+    g_quottery_number_bet_slot = 0;
+    g_quottery_amount_per_bet_slot = 0;
+    g_quottery_picked_option = 0;
+    g_qutil_sendtomanyv1_payout_list_file = nullptr;
+    memset(g_get_log_passcode, 0, sizeof(g_get_log_passcode));
+}
@@ -1,9 +1,25 @@
+#include <array>
 #include <cstdint>
+#include <map>
+#include <mutex>
 #include <vector>
 #include "keyUtils.h"
 #include "K12AndKeyUtil.h"
 #include "logger.h"
 
+#define DERIVED_KEY_CACHE_SIZE 16
+
+namespace
+{
+    struct DerivedKeys
+    {
+        uint8_t privateKey[32];
+        uint8_t publicKey[32];
+    };
+    std::mutex gDerivedKeysLock;
+    std::map<std::array<uint8_t, 32>, DerivedKeys> gDerivedKeys; // by subseed
+}
+
 bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed)
 {
     uint8_t seedBytes[55];
@@ -30,6 +46,33 @@ void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey)
     encode(P, publicKey);
 }
 
+bool getKeysFromSeed(const uint8_t* seed, uint8_t* subseed, uint8_t* privateKey, uint8_t* publicKey)
+{
+    bool valid = getSubseedFromSeed(seed, subseed);
+    if (!valid) memset(subseed, 0, 32);
+    std::array<uint8_t, 32> key;
+    memcpy(key.data(), subseed, 32);
+    {
+        std::lock_guard<std::mutex> lock(gDerivedKeysLock);
+        auto it = gDerivedKeys.find(key);
+        if (it != gDerivedKeys.end())
+        {
+            memcpy(privateKey, it->second.privateKey, 32);
+            memcpy(publicKey, it->second.publicKey, 32);
+            return valid;
+        }
+    }
+    DerivedKeys keys;
+    getPrivateKeyFromSubSeed(subseed, keys.privateKey);
+    getPublicKeyFromPrivateKey(keys.privateKey, keys.publicKey);
+    memcpy(privateKey, keys.privateKey, 32);
+    memcpy(publicKey, keys.publicKey, 32);
+    std::lock_guard<std::mutex> lock(gDerivedKeysLock);
+    if (gDerivedKeys.size() >= DERIVED_KEY_CACHE_SIZE) gDerivedKeys.clear();
+    gDerivedKeys[key] = keys;
+    return valid;
+}
+
 void getIdentityFromPublicKey(const uint8_t* pubkey, char* dstIdentity, bool isLowerCase)
 {
     uint8_t publicKey[32] ;
@@ -61,6 +104,19 @@ void getTxHashFromDigest(const uint8_t* digest, char* txHash)
     getIdentityFromPublicKey(digest, txHash, isLowerCase);
 }
 
+bool getDigestFromTxHash(const char* txHash, uint8_t* digest)
+{
+    char identity[61] = {0};
+    for (int i = 0; i < 60; i++)
+    {
+        if (txHash[i] < 'a' || txHash[i] > 'z') return false;
+        identity[i] = txHash[i] - 'a' + 'A';
+    }
+    if (!checkSumIdentity(identity)) return false;
+    getPublicKeyFromIdentity(identity, digest);
+    return true;
+}
+
 void getPublicKeyFromIdentity(const char* identity, uint8_t* publicKey)
 {
     unsigned char publicKeyBuffer[32];
@@ -2,8 +2,14 @@
 bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed);
 void getPrivateKeyFromSubSeed(const uint8_t* seed, uint8_t* privateKey);
 void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey);
+// The three above in one call. Keys of the last seeds used are kept, so a long running process (-daemon, -batch)
+// signing again with the same seed skips the public key multiplication. An invalid seed returns false and the keys
+// of a zero subseed. Thread safe
+bool getKeysFromSeed(const uint8_t* seed, uint8_t* subseed, uint8_t* privateKey, uint8_t* publicKey);
 void getIdentityFromPublicKey(const uint8_t* pubkey, char* identity, bool isLowerCase);
 void getTxHashFromDigest(const uint8_t* digest, char* txHash);
+// Inverse of getTxHashFromDigest, false if txHash is not a valid lowercase hash
+bool getDigestFromTxHash(const char* txHash, uint8_t* digest);
 void getPublicKeyFromIdentity(const char* identity, uint8_t* publicKey);
 bool checkSumIdentity(char* identity);
 
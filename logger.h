@@ -2,11 +2,41 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <string>
+
+// When set, LOG on this thread appends to the buffer instead of printing (-batch -jobs keeps the output of each command together)
+inline std::string*& logCaptureBuffer()
+{
+    static thread_local std::string* buffer = nullptr;
+    return buffer;
+}
 
 static void LOG(const char *fmt, ...)
 {
 	va_list args;
     va_start(args, fmt);
-    vprintf(fmt, args);
+    std::string* capture = logCaptureBuffer();
+    if (capture)
+    {
+        char text[1024];
+        va_list copy;
+        va_copy(copy, args);
+        int n = vsnprintf(text, sizeof(text), fmt, args);
+        if (n >= int(sizeof(text)))
+        {
+            std::string longText(n + 1, '\0');
+            vsnprintf(&longText[0], n + 1, fmt, copy);
+            capture->append(longText.data(), n);
+        }
+        else if (n > 0)
+        {
+            capture->append(text, n);
+        }
+        va_end(copy);
+    }
+    else
+    {
+        vprintf(fmt, args);
+    }
     va_end(args);
-}
\ No newline at end of file
+}
@@ -11,16 +11,32 @@
 #include "quottery.h"
 #include "qutil.h"
 #include "qx.h"
+#include "nodeFanout.h"
+#include "capture.h"
+#include "nodeDiscovery.h"
+#include "nodeRouter.h"
+#include "daemon.h"
+#include "tickFetcher.h"
+#include "tickArchive.h"
+#include "tickVerifier.h"
+#include "quorumUtils.h"
+#include "txIndex.h"
 
-int run(int argc, char* argv[])
+static int runCommand()
 {
-    parseArgument(argc, argv);
     switch (g_cmd){
         case SHOW_KEYS:
             sanityCheckSeed(g_seed);
             printWalletInfo(g_seed);
             break;
         case GET_CURRENT_TICK:
+            if (g_nodeIps)
+            {
+                auto nodes = parseNodeList(g_nodeIps, g_nodePort);
+                sanityCheckNodeList(nodes);
+                printTickInfoFanout(nodes, parseFanoutPolicy(g_fanoutPolicy));
+                break;
+            }
             sanityCheckNode(g_nodeIp, g_nodePort);
             printTickInfoFromNode(g_nodeIp, g_nodePort);
             break;
@@ -30,9 +46,21 @@ int run(int argc, char* argv[])
             break;
         case GET_BALANCE:
             sanityCheckIdentity(g_requestedIdentity);
+            if (g_nodeIps)
+            {
+                auto nodes = parseNodeList(g_nodeIps, g_nodePort);
+                sanityCheckNodeList(nodes);
+                printBalanceFanout(nodes, parseFanoutPolicy(g_fanoutPolicy), g_requestedIdentity);
+                break;
+            }
             sanityCheckNode(g_nodeIp, g_nodePort);
             printBalance(g_requestedIdentity, g_nodeIp, g_nodePort);
             break;
+        case GET_BALANCES:
+            sanityFileExist(g_requestedFileName);
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            printBalances(g_requestedFileName, g_nodeIp, g_nodePort);
+            break;
         case GET_ASSET:
             sanityCheckIdentity(g_requestedIdentity);
             sanityCheckNode(g_nodeIp, g_nodePort);
@@ -76,28 +104,113 @@ int run(int argc, char* argv[])
             sendRawPacket(g_nodeIp, g_nodePort, g_rawPacketSize, g_rawPacket);
             break;
         case GET_TICK_DATA:
+            if (g_nodeIps)
+            {
+                auto nodes = parseNodeList(g_nodeIps, g_nodePort);
+                sanityCheckNodeList(nodes);
+                getTickDataToFileFanout(nodes, parseFanoutPolicy(g_fanoutPolicy), g_requestedTickNumber, g_requestedFileName);
+                break;
+            }
             sanityCheckNode(g_nodeIp, g_nodePort);
             getTickDataToFile(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName);
             break;
+        case GET_TICK_DATA_RANGE:
+        {
+            std::vector<NodeAddress> nodes;
+            if (g_nodeIps)
+            {
+                nodes = parseNodeList(g_nodeIps, g_nodePort);
+                sanityCheckNodeList(nodes);
+            }
+            else
+            {
+                sanityCheckNode(g_nodeIp, g_nodePort);
+                NodeAddress node;
+                node.ip = g_nodeIp;
+                node.port = g_nodePort;
+                nodes.push_back(node);
+            }
+            sanityCheckTickRange(g_requestedTickNumber, g_requestedTickNumber2);
+            sanityCheckJobs(g_jobs, g_replayFile);
+            getTickDataRange(nodes, g_requestedTickNumber, g_requestedTickNumber2, g_requestedFileName, g_jobs, g_rateLimit);
+            break;
+        }
+        case ARCHIVE_TICKS:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            archiveTicks(g_nodeIp, g_nodePort, g_requestedFileName, g_requestedTickNumber);
+            break;
+        case ARCHIVE_INFO:
+            sanityFileExist(g_requestedFileName);
+            printTickArchiveInfo(g_requestedFileName);
+            break;
+        case READ_ARCHIVE_TICK:
+            sanityFileExist(g_requestedFileName);
+            extractTickFromArchive(g_requestedFileName, g_requestedTickNumber, g_requestedFileName2);
+            break;
+        case FOLLOW_TICKS:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            followTicks(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName);
+            break;
         case GET_QUORUM_TICK:
             sanityCheckNode(g_nodeIp, g_nodePort);
-            getQuorumTick(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName);
+            sanityCheckJobs(g_jobs, nullptr);
+            getQuorumTick(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName, g_jobs);
+            break;
+        case QUORUM_RANGE:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            sanityFileExist(g_requestedFileName);
+            sanityCheckTickRange(g_requestedTickNumber, g_requestedTickNumber2);
+            sanityCheckJobs(g_jobs, nullptr);
+            getQuorumRange(g_nodeIp, g_nodePort, g_requestedFileName, g_requestedTickNumber, g_requestedTickNumber2,
+                           g_requestedFileName2, g_jobs);
             break;
         case READ_TICK_DATA:
             sanityFileExist(g_requestedFileName);
             sanityFileExist(g_requestedFileName2);
-            printTickDataFromFile(g_requestedFileName, g_requestedFileName2);
+            sanityCheckJobs(g_jobs, nullptr);
+            printTickDataFromFile(g_requestedFileName, g_requestedFileName2, g_jobs);
+            break;
+        case VERIFY_TICK_FILES:
+            sanityFileExist(g_requestedFileName);
+            sanityFileExist(g_requestedFileName2);
+            sanityCheckJobs(g_jobs, nullptr);
+            verifyTickFiles(g_requestedFileName, g_requestedFileName2, g_jobs);
             break;
         case CHECK_TX_ON_FILE:
             sanityFileExist(g_requestedFileName);
             sanityCheckTxHash(g_requestedTxId);
             checkTxOnFile(g_requestedTxId, g_requestedFileName);
             break;
+        case CHECK_TX_ON_ARCHIVES:
+        {
+            sanityCheckTxHash(g_requestedTxId);
+            std::vector<std::string> files;
+            for (int i = 0; i < g_requestedFileCount; i++)
+            {
+                sanityFileExist(g_requestedFiles[i]);
+                files.push_back(g_requestedFiles[i]);
+            }
+            sanityCheckFileCount(g_requestedFileCount);
+            checkTxOnArchives(g_requestedTxId, files);
+            break;
+        }
+        case BUILD_TX_INDEX:
+        {
+            std::vector<std::string> files;
+            for (int i = 0; i < g_requestedFileCount; i++)
+            {
+                sanityFileExist(g_requestedFiles[i]);
+                files.push_back(g_requestedFiles[i]);
+            }
+            sanityCheckFileCount(g_requestedFileCount);
+            buildTxIndexes(files);
+            break;
+        }
         case PUBLISH_PROPOSAL:
-            printf("On development. Come back later\n");
+            LOG("On development. Come back later\n");
             break;
         case VOTE_PROPOSAL:
-            printf("On development. Come back later\n");
+            LOG("On development. Come back later\n");
             break;
         case QX_ISSUE_ASSET:
             sanityCheckNode(g_nodeIp, g_nodePort);
@@ -168,6 +281,11 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             getComputorListToFile(g_nodeIp, g_nodePort, g_requestedFileName);
             break;
+        case CRAWL_PEERS:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            sanityCheckCrawl(g_crawlDepth, g_crawlWidth);
+            crawlPeersToFile(g_nodeIp, g_nodePort, g_crawlDepth, g_crawlWidth, g_requestedFileName);
+            break;
         case GET_NODE_IP_LIST:
             sanityCheckNode(g_nodeIp, g_nodePort);
             getNodeIpList(g_nodeIp, g_nodePort);
@@ -187,6 +305,13 @@ int run(int argc, char* argv[])
             dumpUniverseToCSV(g_dump_binary_file_input, g_dump_binary_file_output);
             break;
         case PRINT_QX_FEE:
+            if (g_nodeIps)
+            {
+                auto nodes = parseNodeList(g_nodeIps, g_nodePort);
+                sanityCheckNodeList(nodes);
+                printQxFeeFanout(nodes, parseFanoutPolicy(g_fanoutPolicy));
+                break;
+            }
             sanityCheckNode(g_nodeIp, g_nodePort);
             printQxFee(g_nodeIp, g_nodePort);
             break;
@@ -287,12 +412,61 @@ int run(int argc, char* argv[])
             break;
 
         default:
-            printf("Unexpected command!\n");
+            LOG("Unexpected command!\n");
             break;
     }
     return 0;
 }
 
+// Runs one request of -daemon or one line of -batch. The process wide setup (capture, node routing) is done once in run().
+static int runRequest(int argc, char* argv[])
+{
+    resetGlobals();
+    parseArgument(argc, argv);
+    return runCommand();
+}
+
+int run(int argc, char* argv[])
+{
+    parseArgument(argc, argv);
+    if (g_recordFile && !startCaptureRecording(g_recordFile))
+    {
+        LOG("Failed to create capture file %s\n", g_recordFile);
+        return -1;
+    }
+    if (g_replayFile && !startCaptureReplay(g_replayFile))
+    {
+        LOG("Failed to read capture file %s\n", g_replayFile);
+        return -1;
+    }
+    if (g_nodeListFile)
+    {
+        sanityFileExist(g_nodeListFile);
+        auto nodes = readNodeListFile(g_nodeListFile, g_nodePort);
+        sanityCheckNodeList(nodes);
+        enableNodeRouting(nodes, g_nodeIp, g_nodePort);
+    }
+    if (g_cmd == RUN_DAEMON || g_cmd == RUN_BATCH)
+    {
+        // the basic config given here is put in front of every request
+        std::vector<std::string> baseArgs;
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-daemon") == 0 || strcmp(argv[i], "-batch") == 0)
+            {
+                i++;
+                continue;
+            }
+            baseArgs.push_back(argv[i]);
+        }
+        if (g_cmd == RUN_DAEMON) return runDaemon(g_requestedFileName, baseArgs, runRequest);
+        sanityFileExist(g_requestedFileName);
+        sanityCheckJobs(g_jobs, g_replayFile);
+        return runBatch(g_requestedFileName, baseArgs, g_jobs, runRequest);
+    }
+    return runCommand();
+}
+
 int main(int argc, char* argv[])
 {
     try
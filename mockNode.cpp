@@ -0,0 +1,761 @@
+// qubic-mocknode: a local node that speaks the RequestResponseHeader protocol with synthetic (or recorded) data,
+// so client performance can be measured reproducibly without network access.
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <signal.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "structs.h"
+#include "quottery.h"
+#include "keyUtils.h"
+#include "K12AndKeyUtil.h"
+#include "logger.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is ignored in main
+#endif
+#define MOCK_TICK_CACHE_SIZE 64
+#define MOCK_SEND_CHUNK 4096
+
+typedef std::chrono::steady_clock Clock;
+
+struct MockConfig
+{
+    int port = DEFAULT_NODE_PORT;
+    int latencyMs = 0;          // one-way delay added to every answer
+    long long throughput = 0;   // bytes per second per connection, 0 = unlimited
+    int txPerTick = 16;         // synthetic transactions in every tick
+    int tickDuration = 1000;    // ms
+    unsigned short epoch = 100;
+    unsigned int initialTick = 10000000;
+    uint8_t peers[4][4] = {{127, 0, 0, 1}, {127, 0, 0, 1}, {127, 0, 0, 1}, {127, 0, 0, 1}};
+    std::vector<std::string> tickFiles;
+    int badVotes = 0;           // computors 1 to badVotes send faulty votes
+    int emptyTicks = 0;         // every emptyTicks-th tick has no tick data, 0 = none
+    bool verbose = false;
+};
+
+struct TickRecord
+{
+    TickData td;
+    std::vector<std::vector<uint8_t>> transactions; // Transaction + input + signature
+    std::vector<Tick> votes;                        // generated on first quorum request
+    bool empty = false;                             // no tick data, the quorum votes a zero transaction digest
+};
+
+static MockConfig gConfig;
+static Clock::time_point gStart;
+
+static uint8_t gSubseeds[NUMBER_OF_COMPUTORS][32];
+static BroadcastComputors gComputors;
+
+static std::mutex gTickLock;
+static std::map<uint32_t, std::shared_ptr<TickRecord>> gTickCache;
+static std::map<uint32_t, std::shared_ptr<TickRecord>> gRecordedTicks;
+static std::map<uint32_t, std::vector<std::vector<uint8_t>>> gBroadcastTxs; // scheduled tick -> transactions
+
+static uint32_t currentTick()
+{
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - gStart).count();
+    return gConfig.initialTick + uint32_t(elapsed / gConfig.tickDuration);
+}
+
+// Computor i uses a seed whose first letters spell i in base 26, computor 0 is DEFAULT_SEED
+static void makeComputorSeed(int index, char* seed)
+{
+    memset(seed, 'a', 55);
+    seed[55] = 0;
+    for (int i = 0; index; i++, index /= 26) seed[i] = char('a' + index % 26);
+}
+
+static void initComputors()
+{
+    memset(&gComputors, 0, sizeof(gComputors));
+    gComputors.computors.epoch = gConfig.epoch;
+    for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        char seed[56];
+        uint8_t privateKey[32];
+        alignas(32) uint8_t publicKey[32];
+        makeComputorSeed(i, seed);
+        getSubseedFromSeed((uint8_t*)seed, gSubseeds[i]);
+        getPrivateKeyFromSubSeed(gSubseeds[i], privateKey);
+        getPublicKeyFromPrivateKey(privateKey, publicKey);
+        memcpy(gComputors.computors.publicKeys[i], publicKey, 32);
+    }
+    // not signed by the arbitrator, -getcomputorlist reports the list as unverified
+}
+
+// Signs digest as computorIndex. sign() loads its arguments as __m256i, the keys and signatures of the packed packets
+// are not aligned for that, so it works on aligned copies
+static void signAs(int computorIndex, const uint8_t* digest, uint8_t* signature)
+{
+    alignas(32) uint8_t publicKey[32];
+    alignas(32) uint8_t alignedDigest[32];
+    alignas(32) uint8_t alignedSignature[SIGNATURE_SIZE];
+    memcpy(publicKey, gComputors.computors.publicKeys[computorIndex], 32);
+    memcpy(alignedDigest, digest, 32);
+    sign(gSubseeds[computorIndex], publicKey, alignedDigest, alignedSignature);
+    memcpy(signature, alignedSignature, SIGNATURE_SIZE);
+}
+
+static void setTickTime(uint32_t tick, unsigned short& millisecond, unsigned char& second, unsigned char& minute,
+                        unsigned char& hour, unsigned char& day, unsigned char& month, unsigned char& year)
+{
+    // fixed origin so that the same tick always has the same content
+    long long ms = 1704067200000LL + (long long)(tick - gConfig.initialTick) * gConfig.tickDuration;
+    time_t t = time_t(ms / 1000);
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    millisecond = (unsigned short)(ms % 1000);
+    second = tmv.tm_sec;
+    minute = tmv.tm_min;
+    hour = tmv.tm_hour;
+    day = tmv.tm_mday;
+    month = tmv.tm_mon + 1;
+    year = tmv.tm_year % 100;
+}
+
+static std::vector<uint8_t> makeTransaction(uint32_t tick, int index)
+{
+    int src = (tick + index) % NUMBER_OF_COMPUTORS;
+    int dst = (tick + index + 1) % NUMBER_OF_COMPUTORS;
+    std::vector<uint8_t> raw(sizeof(Transaction) + SIGNATURE_SIZE);
+    Transaction* tx = (Transaction*)raw.data();
+    memcpy(tx->sourcePublicKey, gComputors.computors.publicKeys[src], 32);
+    memcpy(tx->destinationPublicKey, gComputors.computors.publicKeys[dst], 32);
+    tx->amount = 1 + index;
+    tx->tick = tick;
+    tx->inputType = 0;
+    tx->inputSize = 0;
+    uint8_t digest[32];
+    KangarooTwelve(raw.data(), sizeof(Transaction), digest, 32);
+    signAs(src, digest, raw.data() + sizeof(Transaction));
+    return raw;
+}
+
+static std::shared_ptr<TickRecord> generateTick(uint32_t tick)
+{
+    std::shared_ptr<TickRecord> record(new TickRecord());
+    TickData& td = record->td;
+    memset(&td, 0, sizeof(TickData));
+    td.computorIndex = tick % NUMBER_OF_COMPUTORS;
+    td.epoch = gConfig.epoch;
+    td.tick = tick;
+    setTickTime(tick, td.millisecond, td.second, td.minute, td.hour, td.day, td.month, td.year);
+    if (gConfig.emptyTicks && tick % gConfig.emptyTicks == 0)
+    {
+        record->empty = true;
+        return record;
+    }
+
+    for (int i = 0; i < gConfig.txPerTick && i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        record->transactions.push_back(makeTransaction(tick, i));
+    // kept after use, an evicted tick must come back with the same transactions
+    auto it = gBroadcastTxs.find(tick);
+    if (it != gBroadcastTxs.end())
+    {
+        for (auto& raw : it->second)
+        {
+            if (record->transactions.size() >= NUMBER_OF_TRANSACTIONS_PER_TICK) break;
+            record->transactions.push_back(raw);
+        }
+    }
+    for (size_t i = 0; i < record->transactions.size(); i++)
+    {
+        auto& raw = record->transactions[i];
+        KangarooTwelve(raw.data(), (unsigned int)raw.size(), td.transactionDigests[i], 32);
+    }
+
+    uint8_t digest[32];
+    int computorIndex = td.computorIndex;
+    td.computorIndex ^= BROADCAST_FUTURE_TICK_DATA;
+    KangarooTwelve((uint8_t*)&td, sizeof(TickData) - SIGNATURE_SIZE, digest, 32);
+    td.computorIndex = computorIndex;
+    signAs(computorIndex, digest, td.signature);
+    return record;
+}
+
+// Returns the tick, nullptr if it has not happened yet. Must be called with gTickLock held.
+static std::shared_ptr<TickRecord> getTick(uint32_t tick)
+{
+    auto recorded = gRecordedTicks.find(tick);
+    if (recorded != gRecordedTicks.end()) return recorded->second;
+    if (tick < gConfig.initialTick || tick > currentTick()) return nullptr;
+    auto it = gTickCache.find(tick);
+    if (it != gTickCache.end()) return it->second;
+    auto record = generateTick(tick);
+    gTickCache[tick] = record;
+    if (gTickCache.size() > MOCK_TICK_CACHE_SIZE) gTickCache.erase(gTickCache.begin());
+    return record;
+}
+
+// Digests of the state after tick, they only need to be stable and different for every tick
+static void stateDigest(char tag, uint32_t tick, uint8_t* out, unsigned int outSize)
+{
+    uint8_t input[5];
+    input[0] = tag;
+    memcpy(input + 1, &tick, 4);
+    KangarooTwelve(input, 5, out, outSize);
+}
+
+static void saltDigest(const uint8_t* publicKey, const uint8_t* digest, unsigned int digestSize, uint8_t* out, unsigned int outSize)
+{
+    uint8_t saltedData[64] = {0};
+    memcpy(saltedData, publicKey, 32);
+    memcpy(saltedData + 32, digest, digestSize);
+    KangarooTwelve(saltedData, 32 + digestSize, out, outSize);
+}
+
+// Votes of all computors for tick, salted like a real quorum so -getquorumtick passes its checks
+static void generateVotes(TickRecord& record, TickRecord* nextRecord)
+{
+    uint32_t tick = record.td.tick;
+    uint8_t txDigest[32] = {0}, nextTxDigest[32] = {0};
+    if (!record.empty) KangarooTwelve((uint8_t*)&record.td, sizeof(TickData), txDigest, 32);
+    if (nextRecord && !nextRecord->empty) KangarooTwelve((uint8_t*)&nextRecord->td, sizeof(TickData), nextTxDigest, 32);
+
+    unsigned long long prevResource, resource;
+    uint8_t prevSpectrum[32], prevUniverse[32], prevComputer[32];
+    uint8_t spectrum[32], universe[32], computer[32];
+    stateDigest('r', tick - 1, (uint8_t*)&prevResource, 8);
+    stateDigest('r', tick, (uint8_t*)&resource, 8);
+    stateDigest('s', tick - 1, prevSpectrum, 32);
+    stateDigest('s', tick, spectrum, 32);
+    stateDigest('u', tick - 1, prevUniverse, 32);
+    stateDigest('u', tick, universe, 32);
+    stateDigest('c', tick - 1, prevComputer, 32);
+    stateDigest('c', tick, computer, 32);
+
+    record.votes.resize(NUMBER_OF_COMPUTORS);
+    for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        Tick& vote = record.votes[i];
+        const uint8_t* publicKey = gComputors.computors.publicKeys[i];
+        memset(&vote, 0, sizeof(Tick));
+        vote.computorIndex = i;
+        vote.epoch = gConfig.epoch;
+        vote.tick = tick;
+        setTickTime(tick, vote.millisecond, vote.second, vote.minute, vote.hour, vote.day, vote.month, vote.year);
+        vote.prevResourceTestingDigest = prevResource;
+        saltDigest(publicKey, (uint8_t*)&resource, 8, (uint8_t*)&vote.saltedResourceTestingDigest, 8);
+        memcpy(vote.prevSpectrumDigest, prevSpectrum, 32);
+        memcpy(vote.prevUniverseDigest, prevUniverse, 32);
+        memcpy(vote.prevComputerDigest, prevComputer, 32);
+        saltDigest(publicKey, spectrum, 32, vote.saltedSpectrumDigest, 32);
+        saltDigest(publicKey, universe, 32, vote.saltedUniverseDigest, 32);
+        saltDigest(publicKey, computer, 32, vote.saltedComputerDigest, 32);
+        memcpy(vote.transactionDigest, txDigest, 32);
+        memcpy(vote.expectedNextTickTransactionDigest, nextTxDigest, 32);
+        // faulty computors alternate between a wrong salt and a disagreeing vote, every third one signs wrongly
+        bool faulty = i >= 1 && i <= gConfig.badVotes;
+        if (faulty && i % 2) vote.saltedSpectrumDigest[0] ^= 1;
+        if (faulty && !(i % 2)) vote.transactionDigest[0] ^= 1;
+
+        uint8_t digest[32];
+        vote.computorIndex ^= Tick::type();
+        KangarooTwelve((uint8_t*)&vote, sizeof(Tick) - SIGNATURE_SIZE, digest, 32);
+        vote.computorIndex ^= Tick::type();
+        signAs(i, digest, vote.signature);
+        if (faulty && i % 3 == 0) vote.signature[40] ^= 1;
+    }
+}
+
+static bool loadTickFile(const char* fileName)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f) return false;
+    std::shared_ptr<TickRecord> record(new TickRecord());
+    bool ok = fread(&record->td, 1, sizeof(TickData), f) == sizeof(TickData);
+    uint8_t zero[32] = {0};
+    for (int i = 0; ok && i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+    {
+        if (memcmp(record->td.transactionDigests[i], zero, 32) == 0) continue;
+        Transaction tx;
+        if (fread(&tx, 1, sizeof(Transaction), f) != sizeof(Transaction))
+        {
+            ok = false;
+            break;
+        }
+        std::vector<uint8_t> raw(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
+        memcpy(raw.data(), &tx, sizeof(Transaction));
+        size_t rest = raw.size() - sizeof(Transaction);
+        ok = fread(raw.data() + sizeof(Transaction), 1, rest, f) == rest;
+        record->transactions.push_back(raw);
+    }
+    fclose(f);
+    if (ok) gRecordedTicks[record->td.tick] = record;
+    return ok;
+}
+
+static RespondedEntity makeEntity(const uint8_t* publicKey)
+{
+    RespondedEntity re;
+    memset(&re, 0, sizeof(re));
+    uint8_t digest[32];
+    KangarooTwelve(publicKey, 32, digest, 32);
+    unsigned long long seed;
+    memcpy(&seed, digest, 8);
+    memcpy(re.entity.publicKey, publicKey, 32);
+    re.entity.incomingAmount = 1000000000LL + (long long)(seed % 1000000000ULL);
+    re.entity.outgoingAmount = (long long)((seed >> 32) % 1000000ULL);
+    re.entity.numberOfIncomingTransfers = 1 + (seed >> 8) % 100;
+    re.entity.numberOfOutgoingTransfers = (seed >> 16) % 100;
+    re.entity.latestIncomingTransferTick = gConfig.initialTick;
+    re.entity.latestOutgoingTransferTick = gConfig.initialTick;
+    re.tick = currentTick();
+    re.spectrumIndex = int(seed % 0x1000000);
+    return re;
+}
+
+// Answers of one connection are delivered by a writer thread after the configured latency,
+// so pipelined requests overlap the way they would on a real link.
+class MockSession
+{
+public:
+    explicit MockSession(int fd) : mFd(fd), mClosed(false) {}
+
+    void run()
+    {
+        std::thread writer(&MockSession::writeLoop, this);
+        ExchangePublicPeers epp;
+        memcpy(epp.peers, gConfig.peers, sizeof(epp.peers));
+        answer(EXCHANGE_PUBLIC_PEERS, 0, &epp, sizeof(epp));
+        readLoop();
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            mClosed = true;
+        }
+        mChanged.notify_all();
+        writer.join();
+        close(mFd);
+    }
+
+private:
+    struct Outgoing
+    {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+    };
+
+    bool recvAll(void* buffer, size_t size)
+    {
+        uint8_t* ptr = (uint8_t*)buffer;
+        while (size)
+        {
+            ssize_t n = recv(mFd, ptr, size, 0);
+            if (n <= 0) return false;
+            ptr += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool sendAll(const uint8_t* data, size_t size)
+    {
+        while (size)
+        {
+            size_t chunk = size;
+            if (gConfig.throughput > 0 && chunk > MOCK_SEND_CHUNK) chunk = MOCK_SEND_CHUNK;
+            ssize_t n = send(mFd, data, chunk, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            data += n;
+            size -= n;
+            if (gConfig.throughput > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(n * 1000000LL / gConfig.throughput));
+        }
+        return true;
+    }
+
+    void answer(uint8_t type, unsigned int dejavu, const void* payload, size_t payloadSize)
+    {
+        Outgoing out;
+        out.due = Clock::now() + std::chrono::milliseconds(gConfig.latencyMs);
+        out.data.resize(sizeof(RequestResponseHeader) + payloadSize);
+        auto header = (RequestResponseHeader*)out.data.data();
+        header->setSize((unsigned int)out.data.size());
+        header->setType(type);
+        header->setDejavu(dejavu);
+        if (payloadSize) memcpy(out.data.data() + sizeof(RequestResponseHeader), payload, payloadSize);
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            mQueue.push_back(std::move(out));
+        }
+        mChanged.notify_all();
+    }
+
+    void writeLoop()
+    {
+        std::unique_lock<std::mutex> guard(mLock);
+        while (true)
+        {
+            if (mQueue.empty())
+            {
+                if (mClosed) return;
+                mChanged.wait(guard);
+                continue;
+            }
+            if (Clock::now() < mQueue.front().due)
+            {
+                mChanged.wait_until(guard, mQueue.front().due);
+                continue;
+            }
+            Outgoing out = std::move(mQueue.front());
+            mQueue.pop_front();
+            guard.unlock();
+            bool ok = sendAll(out.data.data(), out.data.size());
+            guard.lock();
+            if (!ok)
+            {
+                mQueue.clear();
+                shutdown(mFd, SHUT_RDWR);
+                return;
+            }
+        }
+    }
+
+    void readLoop()
+    {
+        std::vector<uint8_t> payload;
+        while (true)
+        {
+            RequestResponseHeader header;
+            if (!recvAll(&header, sizeof(header))) return;
+            unsigned int size = header.size();
+            if (size < sizeof(header) || size > 0xFFFFFF) return;
+            payload.resize(size - sizeof(header));
+            if (!payload.empty() && !recvAll(payload.data(), payload.size())) return;
+            if (gConfig.verbose) LOG("[%d] request type %d, %u bytes\n", mFd, header.type(), size);
+            handle(header.type(), header.dejavu(), payload);
+        }
+    }
+
+    void handle(uint8_t type, unsigned int dejavu, const std::vector<uint8_t>& payload)
+    {
+        switch (type)
+        {
+            case REQUEST_CURRENT_TICK_INFO:
+            {
+                CurrentTickInfo info;
+                memset(&info, 0, sizeof(info));
+                info.tickDuration = gConfig.tickDuration;
+                info.epoch = gConfig.epoch;
+                info.tick = currentTick();
+                info.numberOfAlignedVotes = NUMBER_OF_COMPUTORS;
+                info.initialTick = gConfig.initialTick;
+                answer(RESPOND_CURRENT_TICK_INFO, dejavu, &info, sizeof(info));
+                break;
+            }
+            case REQUEST_SYSTEM_INFO:
+            {
+                CurrentSystemInfo info;
+                memset(&info, 0, sizeof(info));
+                info.epoch = gConfig.epoch;
+                info.tick = currentTick();
+                info.initialTick = gConfig.initialTick;
+                info.latestCreatedTick = info.tick;
+                info.numberOfEntities = NUMBER_OF_COMPUTORS;
+                answer(RESPOND_SYSTEM_INFO, dejavu, &info, sizeof(info));
+                break;
+            }
+            case REQUEST_ENTITY:
+            {
+                if (payload.size() < sizeof(RequestedEntity)) break;
+                RespondedEntity re = makeEntity(((const RequestedEntity*)payload.data())->publicKey);
+                answer(RESPOND_ENTITY, dejavu, &re, sizeof(re));
+                break;
+            }
+            case REQUEST_COMPUTORS:
+                answer(BROADCAST_COMPUTORS, dejavu, &gComputors, sizeof(gComputors));
+                break;
+            case REQUEST_TICK_DATA:
+            {
+                if (payload.size() < sizeof(RequestedTickData)) break;
+                std::shared_ptr<TickRecord> record;
+                {
+                    std::lock_guard<std::mutex> guard(gTickLock);
+                    record = getTick(((const RequestedTickData*)payload.data())->tick);
+                }
+                if (record && !record->empty) answer(BROADCAST_FUTURE_TICK_DATA, dejavu, &record->td, sizeof(TickData));
+                else answer(END_RESPONSE, dejavu, nullptr, 0);
+                break;
+            }
+            case REQUEST_TICK_TRANSACTIONS:
+            {
+                if (payload.size() < sizeof(RequestedTickTransactions)) break;
+                auto request = (const RequestedTickTransactions*)payload.data();
+                std::shared_ptr<TickRecord> record;
+                {
+                    std::lock_guard<std::mutex> guard(gTickLock);
+                    record = getTick(request->tick);
+                }
+                for (size_t i = 0; record && i < record->transactions.size(); i++)
+                {
+                    if (request->transactionFlags[i >> 3] & (1 << (i & 7))) continue;
+                    auto& raw = record->transactions[i];
+                    answer(BROADCAST_TRANSACTION, dejavu, raw.data(), raw.size());
+                }
+                answer(END_RESPONSE, dejavu, nullptr, 0);
+                break;
+            }
+            case RequestedQuorumTick::type:
+            {
+                if (payload.size() < sizeof(RequestedQuorumTick)) break;
+                auto request = (const RequestedQuorumTick*)payload.data();
+                std::shared_ptr<TickRecord> record;
+                {
+                    // votes exist once the next tick has started
+                    std::lock_guard<std::mutex> guard(gTickLock);
+                    if (request->tick < currentTick()) record = getTick(request->tick);
+                    if (record && record->votes.empty())
+                    {
+                        auto next = getTick(request->tick + 1);
+                        generateVotes(*record, next.get());
+                    }
+                }
+                for (int i = 0; record && i < NUMBER_OF_COMPUTORS; i++)
+                {
+                    if (request->voteFlags[i >> 3] & (1 << (i & 7))) continue;
+                    answer(Tick::type(), dejavu, &record->votes[i], sizeof(Tick));
+                }
+                answer(END_RESPONSE, dejavu, nullptr, 0);
+                break;
+            }
+            case REQUEST_TX_STATUS:
+            {
+                if (payload.size() < sizeof(RequestTxStatus)) break;
+                std::shared_ptr<TickRecord> record;
+                {
+                    std::lock_guard<std::mutex> guard(gTickLock);
+                    record = getTick(((const RequestTxStatus*)payload.data())->tick);
+                }
+                if (!record)
+                {
+                    answer(END_RESPONSE, dejavu, nullptr, 0);
+                    break;
+                }
+                std::unique_ptr<RespondTxStatus> status(new RespondTxStatus());
+                memset(status.get(), 0, sizeof(RespondTxStatus));
+                status->currentTickOfNode = currentTick();
+                status->tick = record->td.tick;
+                status->txCount = (unsigned int)record->transactions.size();
+                for (unsigned int i = 0; i < status->txCount; i++)
+                {
+                    status->moneyFlew[i >> 3] |= 1 << (i & 7);
+                    memcpy(status->txDigests[i], record->td.transactionDigests[i], 32);
+                }
+                answer(RESPOND_TX_STATUS, dejavu, status.get(), status->size());
+                break;
+            }
+            case BROADCAST_TRANSACTION:
+            {
+                if (payload.size() < sizeof(Transaction)) break;
+                auto tx = (const Transaction*)payload.data();
+                if (payload.size() != sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE) break;
+                // like a real node, transactions for ticks that have already started are dropped
+                std::lock_guard<std::mutex> guard(gTickLock);
+                if (tx->tick > currentTick()) gBroadcastTxs[tx->tick].push_back(payload);
+                break;
+            }
+            case RequestContractFunction::type():
+                handleContractFunction(dejavu, payload);
+                break;
+            default:
+                // a real node ignores what it does not know
+                break;
+        }
+    }
+
+    void handleContractFunction(unsigned int dejavu, const std::vector<uint8_t>& payload)
+    {
+        if (payload.size() < sizeof(RequestContractFunction)) return;
+        auto rcf = (const RequestContractFunction*)payload.data();
+        if (rcf->contractIndex == QX_CONTRACT_INDEX && rcf->inputType == QX_FEE_FUNCTION_INDEX)
+        {
+            QxFees_output fees;
+            fees.assetIssuanceFee = 1000000000;
+            fees.transferFee = 1000000;
+            fees.tradeFee = 5000000;
+            answer(RespondContractFunction::type(), dejavu, &fees, sizeof(fees));
+        }
+        else if (rcf->contractIndex == 2 && rcf->inputType == 1) // Quottery basic info
+        {
+            qtryBasicInfo_output info;
+            memset(&info, 0, sizeof(info));
+            info.feePerSlotPerDay = 10000;
+            info.gameOperatorFee = 50;
+            info.shareholderFee = 1000;
+            info.minBetSlotAmount = 10000;
+            info.burnFee = 200;
+            memcpy(info.gameOperator, gComputors.computors.publicKeys[0], 32);
+            answer(RespondContractFunction::type(), dejavu, &info, sizeof(info));
+        }
+        else if (rcf->contractIndex == 4 && rcf->inputType == 1) // QUtil GetSendToManyV1Fee
+        {
+            GetSendToManyV1Fee_output fee;
+            fee.fee = 10;
+            answer(RespondContractFunction::type(), dejavu, &fee, sizeof(fee));
+        }
+        else
+        {
+            // unknown function, an empty answer is what a node sends when the invocation failed
+            answer(RespondContractFunction::type(), dejavu, nullptr, 0);
+        }
+    }
+
+    int mFd;
+    std::mutex mLock;
+    std::condition_variable mChanged;
+    std::deque<Outgoing> mQueue;
+    bool mClosed;
+};
+
+static void printUsage()
+{
+    LOG("./qubic-mocknode [options]\n");
+    LOG("\t-port <PORT>\n\t\tListening port (default: %d)\n", DEFAULT_NODE_PORT);
+    LOG("\t-latency <MS>\n\t\tDelay added to every answer (default: 0)\n");
+    LOG("\t-throughput <BYTES_PER_SECOND>\n\t\tSending rate of every connection, 0 is unlimited (default: 0)\n");
+    LOG("\t-txpertick <NUMBER>\n\t\tSynthetic transactions in every tick (default: 16)\n");
+    LOG("\t-tickduration <MS>\n\t\tTime between two ticks (default: 1000)\n");
+    LOG("\t-epoch <EPOCH>\n\t\t(default: 100)\n");
+    LOG("\t-initialtick <TICK>\n\t\tTick of the node at start (default: 10000000)\n");
+    LOG("\t-peers <IPv4_ADDRESS,IPv4_ADDRESS,IPv4_ADDRESS,IPv4_ADDRESS>\n\t\tPeers announced to clients (default: 127.0.0.1)\n");
+    LOG("\t-tickfile <FILE>\n\t\tServe a tick recorded with -gettickdata instead of a synthetic one, can be repeated\n");
+    LOG("\t-badvotes <NUMBER>\n\t\tComputors 1 to <NUMBER> send faulty votes: wrong salts, other digests or bad signatures (default: 0)\n");
+    LOG("\t-emptyticks <NUMBER>\n\t\tEvery tick divisible by <NUMBER> has no tick data and an empty tick quorum (default: 0, none)\n");
+    LOG("\t-verbose\n\t\tPrint every request\n");
+    LOG("Computor i uses the seed whose first letters are i in base 26 (a=0), computor 0 is %s\n", DEFAULT_SEED);
+}
+
+static void parsePeers(const char* list)
+{
+    std::string s(list);
+    size_t start = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        size_t end = s.find(',', start);
+        std::string ip = s.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        in_addr addr;
+        if (inet_pton(AF_INET, ip.c_str(), &addr) != 1)
+        {
+            LOG("Invalid peer %s\n", ip.c_str());
+            exit(1);
+        }
+        memcpy(gConfig.peers[i], &addr, 4);
+        if (end == std::string::npos)
+        {
+            // fewer than 4 peers: repeat the last one
+            for (int j = i + 1; j < 4; j++) memcpy(gConfig.peers[j], gConfig.peers[i], 4);
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+static void parseArgument(int argc, char** argv)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-help") == 0)
+        {
+            printUsage();
+            exit(0);
+        }
+        else if (strcmp(argv[i], "-verbose") == 0)
+        {
+            gConfig.verbose = true;
+            i++;
+            continue;
+        }
+        if (!hasValue)
+        {
+            LOG("Missing value for %s\n", argv[i]);
+            exit(1);
+        }
+        const char* value = argv[i + 1];
+        if (strcmp(argv[i], "-port") == 0) gConfig.port = atoi(value);
+        else if (strcmp(argv[i], "-latency") == 0) gConfig.latencyMs = atoi(value);
+        else if (strcmp(argv[i], "-throughput") == 0) gConfig.throughput = atoll(value);
+        else if (strcmp(argv[i], "-txpertick") == 0) gConfig.txPerTick = atoi(value);
+        else if (strcmp(argv[i], "-tickduration") == 0) gConfig.tickDuration = atoi(value);
+        else if (strcmp(argv[i], "-badvotes") == 0) gConfig.badVotes = atoi(value);
+        else if (strcmp(argv[i], "-emptyticks") == 0) gConfig.emptyTicks = atoi(value);
+        else if (strcmp(argv[i], "-epoch") == 0) gConfig.epoch = (unsigned short)atoi(value);
+        else if (strcmp(argv[i], "-initialtick") == 0) gConfig.initialTick = (unsigned int)strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "-peers") == 0) parsePeers(value);
+        else if (strcmp(argv[i], "-tickfile") == 0) gConfig.tickFiles.push_back(value);
+        else
+        {
+            LOG("Unknown option %s\n", argv[i]);
+            printUsage();
+            exit(1);
+        }
+        i += 2;
+    }
+    if (gConfig.tickDuration <= 0 || gConfig.txPerTick < 0 || gConfig.emptyTicks < 0 || gConfig.latencyMs < 0 || gConfig.throughput < 0)
+    {
+        LOG("Invalid option value\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    parseArgument(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+    for (auto& fileName : gConfig.tickFiles)
+    {
+        if (!loadTickFile(fileName.c_str()))
+        {
+            LOG("Failed to read tick file %s\n", fileName.c_str());
+            return 1;
+        }
+    }
+    initComputors();
+
+    int serverFd = socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(gConfig.port);
+    if (bind(serverFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(serverFd, 128) < 0)
+    {
+        LOG("Failed to listen on port %d\n", gConfig.port);
+        return 1;
+    }
+    gStart = Clock::now();
+    LOG("Mock node listening on port %d, epoch %u, initial tick %u, %d tx/tick, latency %dms\n",
+        gConfig.port, gConfig.epoch, gConfig.initialTick, gConfig.txPerTick, gConfig.latencyMs);
+    while (true)
+    {
+        int fd = accept(serverFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        std::thread([fd]()
+        {
+            MockSession session(fd);
+            session.run();
+        }).detach();
+    }
+}
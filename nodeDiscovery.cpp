@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <set>
+#include <thread>
+#include "nodeDiscovery.h"
+#include "asyncConnection.h"
+#include "connection.h"
+#include "logger.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static DiscoveredNode unprobedNode(const NodeAddress& node, int depth)
+{
+    DiscoveredNode result;
+    result.address = node;
+    result.depth = depth;
+    result.reachable = false;
+    result.connectMs = 0;
+    result.rttMs = 0;
+    result.tick = 0;
+    result.epoch = 0;
+    return result;
+}
+
+static void addPeers(DiscoveredNode& result, const ExchangePublicPeers* epp)
+{
+    for (int i = 0; epp && i < 4; i++)
+    {
+        const uint8_t* p = epp->peers[i];
+        if (!p[0] && !p[1] && !p[2] && !p[3]) continue;
+        result.peers.push_back(std::to_string(p[0]) + "." + std::to_string(p[1]) + "." + std::to_string(p[2]) + "." + std::to_string(p[3]));
+    }
+}
+
+DiscoveredNode probeNode(const NodeAddress& node, int depth)
+{
+    DiscoveredNode result = unprobedNode(node, depth);
+    try
+    {
+        // a fresh connection, a pooled one would hide the connect time and the peer announcement
+        auto start = std::chrono::steady_clock::now();
+        QubicConnection qc(node.ip.c_str(), node.port);
+        result.connectMs = elapsedMs(start);
+
+        struct {
+            RequestResponseHeader header;
+        } packet;
+        packet.header.setSize(sizeof(packet));
+        packet.header.randomizeDejavu();
+        packet.header.setType(REQUEST_CURRENT_TICK_INFO);
+        start = std::chrono::steady_clock::now();
+        qc.sendData((uint8_t *) &packet, packet.header.size());
+        ReceiveBuffer buffer;
+        qc.receiveDataUntil(buffer, {RESPOND_CURRENT_TICK_INFO});
+        result.rttMs = elapsedMs(start);
+        for (auto& response : splitPackets(buffer.data(), buffer.size()))
+        {
+            if (response.type() == EXCHANGE_PUBLIC_PEERS)
+            {
+                addPeers(result, response.as<ExchangePublicPeers>());
+            }
+            else if (response.type() == RESPOND_CURRENT_TICK_INFO && response.dejavu() == packet.header.dejavu())
+            {
+                auto info = response.as<CurrentTickInfo>();
+                if (info)
+                {
+                    result.tick = info->tick;
+                    result.epoch = info->epoch;
+                    result.reachable = info->epoch != 0;
+                }
+            }
+        }
+    }
+    catch (std::logic_error&)
+    {
+        result.reachable = false;
+    }
+    return result;
+}
+
+#ifdef __linux__
+std::vector<DiscoveredNode> probeNodes(const std::vector<NodeAddress>& nodes, int depth)
+{
+    std::vector<DiscoveredNode> results(nodes.size());
+    size_t next = 0;
+    size_t finished = 0;
+    // a fresh engine, pooled sessions would hide the connect time and the peer announcement
+    AsyncNodeEngine engine;
+    RequestResponseHeader header;
+    header.setSize(sizeof(header));
+    header.setType(REQUEST_CURRENT_TICK_INFO);
+    std::vector<uint8_t> packet((uint8_t*)&header, (uint8_t*)&header + sizeof(header));
+    std::function<void()> probeNext = [&]()
+    {
+        size_t i = next++;
+        const char* ip = nodes[i].ip.c_str();
+        int port = nodes[i].port;
+        results[i] = unprobedNode(nodes[i], depth);
+        // the session time goes to whichever of the two answers arrives first
+        engine.expect(ip, port, EXCHANGE_PUBLIC_PEERS, [&results, i](const AsyncResponse& response)
+        {
+            results[i].connectMs += response.connectMs;
+            if (response.ok && response.payload.size() >= sizeof(ExchangePublicPeers))
+                addPeers(results[i], (const ExchangePublicPeers*)response.payload.data());
+        });
+        engine.submit(ip, port, packet, RESPOND_CURRENT_TICK_INFO, [&, i](const AsyncResponse& response)
+        {
+            auto& result = results[i];
+            result.connectMs += response.connectMs;
+            result.rttMs = response.rttMs;
+            if (response.ok && response.type == RESPOND_CURRENT_TICK_INFO && response.payload.size() >= sizeof(CurrentTickInfo))
+            {
+                auto info = (const CurrentTickInfo*)response.payload.data();
+                result.tick = info->tick;
+                result.epoch = info->epoch;
+                result.reachable = info->epoch != 0;
+            }
+            finished++;
+            if (next < nodes.size()) probeNext();
+        });
+    };
+    while (next < std::min(nodes.size(), size_t(CRAWL_MAX_PARALLEL))) probeNext();
+    // peers are announced right after connecting, before the tick info answer, so the probe ends with it
+    while (finished < nodes.size()) engine.poll(50);
+    return results;
+}
+#else
+std::vector<DiscoveredNode> probeNodes(const std::vector<NodeAddress>& nodes, int depth)
+{
+    std::vector<DiscoveredNode> results(nodes.size());
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    size_t threads = std::min(nodes.size(), size_t(CRAWL_MAX_PARALLEL));
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t i = next++; i < nodes.size(); i = next++)
+            {
+                results[i] = probeNode(nodes[i], depth);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    return results;
+}
+#endif
+
+std::vector<DiscoveredNode> crawlPeers(const char* seedIp, int seedPort, int maxDepth, int width)
+{
+    std::vector<DiscoveredNode> discovered;
+    std::set<std::string> seen;
+    std::vector<NodeAddress> level;
+    NodeAddress seed;
+    seed.ip = seedIp;
+    seed.port = seedPort;
+    level.push_back(seed);
+    seen.insert(seed.ip);
+    for (int depth = 0; depth <= maxDepth && !level.empty(); depth++)
+    {
+        auto probed = probeNodes(level, depth);
+        level.clear();
+        for (auto& node : probed)
+        {
+            for (auto& peer : node.peers)
+            {
+                if (depth == maxDepth || int(level.size()) >= width) break;
+                if (!seen.insert(peer).second) continue;
+                NodeAddress address;
+                address.ip = peer;
+                address.port = seedPort;
+                level.push_back(address);
+            }
+            discovered.push_back(node);
+        }
+    }
+    return discovered;
+}
+
+void rankNodes(std::vector<DiscoveredNode>& nodes)
+{
+    uint32_t bestTick = 0;
+    for (auto& node : nodes)
+    {
+        if (node.reachable) bestTick = std::max(bestTick, node.tick);
+    }
+    auto lagging = [bestTick](const DiscoveredNode& node)
+    {
+        return node.tick + CRAWL_TICK_LAG_TOLERANCE < bestTick;
+    };
+    std::stable_sort(nodes.begin(), nodes.end(), [&](const DiscoveredNode& a, const DiscoveredNode& b)
+    {
+        if (a.reachable != b.reachable) return a.reachable;
+        if (lagging(a) != lagging(b)) return !lagging(a);
+        return a.rttMs < b.rttMs;
+    });
+}
+
+void crawlPeersToFile(const char* seedIp, int seedPort, int maxDepth, int width, const char* fileName)
+{
+    LOG("Crawling peers from %s:%d (depth %d, width %d)\n", seedIp, seedPort, maxDepth, width);
+    auto start = std::chrono::steady_clock::now();
+    auto nodes = crawlPeers(seedIp, seedPort, maxDepth, width);
+    rankNodes(nodes);
+    FILE* f = fopen(fileName, "w");
+    if (f == nullptr)
+    {
+        LOG("Failed to open %s\n", fileName);
+        return;
+    }
+    fprintf(f, "# ip:port rtt_ms connect_ms tick epoch\n");
+    int reachable = 0;
+    std::string nodeIps;
+    for (auto& node : nodes)
+    {
+        if (!node.reachable)
+        {
+            LOG("%s:%d (depth %d) unreachable\n", node.address.ip.c_str(), node.address.port, node.depth);
+            continue;
+        }
+        LOG("%s:%d (depth %d) rtt %.1fms connect %.1fms tick %u epoch %u\n", node.address.ip.c_str(), node.address.port,
+            node.depth, node.rttMs, node.connectMs, node.tick, node.epoch);
+        fprintf(f, "%s:%d %.1f %.1f %u %u\n", node.address.ip.c_str(), node.address.port, node.rttMs, node.connectMs, node.tick, node.epoch);
+        if (reachable < 8)
+        {
+            if (!nodeIps.empty()) nodeIps += ",";
+            nodeIps += node.address.ip + ":" + std::to_string(node.address.port);
+        }
+        reachable++;
+    }
+    fclose(f);
+    LOG("%d of %d nodes reachable, crawled in %.0fms, ranked list written to %s (use it with -nodelist)\n", reachable, int(nodes.size()),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), fileName);
+    if (reachable) LOG("Best nodes: -nodeips %s\n", nodeIps.c_str());
+}
+
+std::vector<NodeAddress> readNodeListFile(const char* fileName, int defaultPort)
+{
+    std::vector<NodeAddress> nodes;
+    FILE* f = fopen(fileName, "r");
+    if (f == nullptr) return nodes;
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        char address[64] = {0};
+        if (line[0] == '#' || sscanf(line, "%63s", address) != 1) continue;
+        auto parsed = parseNodeList(address, defaultPort);
+        nodes.insert(nodes.end(), parsed.begin(), parsed.end());
+    }
+    fclose(f);
+    return nodes;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "nodeFanout.h"
+
+#define CRAWL_MAX_PARALLEL 32     // nodes probed at the same time
+#define CRAWL_TICK_LAG_TOLERANCE 5 // nodes further behind the highest tick seen are ranked after the others
+
+struct DiscoveredNode
+{
+    NodeAddress address;
+    int depth;          // hops from the seed node, 0 is the seed itself
+    bool reachable;     // connected and answered the tick info request
+    double connectMs;
+    double rttMs;       // tick info request to its answer
+    uint32_t tick;
+    uint16_t epoch;
+    std::vector<std::string> peers; // announced with EXCHANGE_PUBLIC_PEERS
+};
+
+// Probes one node: connect time, tick info round trip and announced peers
+DiscoveredNode probeNode(const NodeAddress& node, int depth);
+// Probes several nodes concurrently (from one AsyncNodeEngine on Linux), results are in the order of nodes
+std::vector<DiscoveredNode> probeNodes(const std::vector<NodeAddress>& nodes, int depth);
+// Breadth first crawl over the peers announced by the nodes, starting from the seed.
+// Every level probes at most width new nodes, all of them concurrently. Peers use the port of the seed.
+std::vector<DiscoveredNode> crawlPeers(const char* seedIp, int seedPort, int maxDepth, int width);
+// Reachable nodes first, current ones (within CRAWL_TICK_LAG_TOLERANCE of the best tick) before lagging ones, then by RTT
+void rankNodes(std::vector<DiscoveredNode>& nodes);
+// Reads a node list written by crawlPeersToFile (or any file with one ip[:port] per line, # starts a comment)
+std::vector<NodeAddress> readNodeListFile(const char* fileName, int defaultPort);
+// Crawls and writes the ranked reachable nodes to fileName, one "ip:port rtt connect tick epoch" per line
+void crawlPeersToFile(const char* seedIp, int seedPort, int maxDepth, int width, const char* fileName);
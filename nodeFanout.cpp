@@ -0,0 +1,249 @@
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "nodeFanout.h"
+#include "nodeUtils.h"
+#include "walletUtils.h"
+#include "keyUtils.h"
+#include "qx.h"
+#include "logger.h"
+#include "daemon.h"
+
+std::vector<NodeAddress> parseNodeList(const char* nodeList, int defaultPort)
+{
+    std::vector<NodeAddress> nodes;
+    std::string list(nodeList ? nodeList : "");
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(start, end - start);
+        if (!item.empty())
+        {
+            NodeAddress node;
+            size_t colon = item.find(':');
+            node.ip = item.substr(0, colon);
+            node.port = (colon == std::string::npos) ? defaultPort : atoi(item.c_str() + colon + 1);
+            nodes.push_back(node);
+        }
+        start = end + 1;
+    }
+    return nodes;
+}
+
+FanoutPolicy parseFanoutPolicy(const char* policy)
+{
+    if (policy == nullptr || strcmp(policy, "fastest") == 0) return FANOUT_FASTEST;
+    if (strcmp(policy, "majority") == 0) return FANOUT_MAJORITY;
+    LOG("Unknown policy %s, expected fastest or majority\n", policy);
+    cliExit(1);
+}
+
+static std::string bytesKey(const void* ptr, size_t size)
+{
+    return std::string((const char*)ptr, size);
+}
+
+// Applies policy to the valid answers so far, true once the answer can not change anymore
+static bool decide(FanoutPolicy policy, const std::vector<bool>& valid, const std::vector<std::string>& keys,
+                   bool allDone, FanoutReport& report)
+{
+    report.answered = 0;
+    report.winner = -1;
+    report.agreeing = 0;
+    std::map<std::string, std::pair<int, int>> votes; // key -> (count, first node)
+    for (size_t i = 0; i < valid.size(); i++)
+    {
+        if (!valid[i]) continue;
+        report.answered++;
+        if (policy == FANOUT_FASTEST)
+        {
+            if (report.winner < 0)
+            {
+                report.winner = int(i);
+                report.agreeing = 1;
+            }
+            continue;
+        }
+        auto& vote = votes[keys[i]];
+        if (vote.first == 0) vote.second = int(i);
+        vote.first++;
+        if (vote.first > report.agreeing)
+        {
+            report.agreeing = vote.first;
+            report.winner = vote.second;
+        }
+    }
+    if (policy == FANOUT_FASTEST) return report.winner >= 0 || allDone;
+    if (report.agreeing * 2 > int(valid.size())) return true;
+    // the most common answer is not a majority of the nodes asked, it does not win even once all have answered
+    report.winner = -1;
+    return allDone;
+}
+
+int fanoutRequest(const std::vector<NodeAddress>& nodes, FanoutPolicy policy,
+                  std::function<bool(size_t, QCPtr, std::string&)> ask, FanoutReport* report)
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<bool> valid(nodes.size(), false);
+    std::vector<std::string> keys(nodes.size());
+    size_t finished = 0;
+    bool decided = false;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        workers.emplace_back([&, i]()
+        {
+            std::string key;
+            bool ok = false;
+            try
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                if (decided) return;
+                guard.unlock();
+                ok = ask(i, make_qc(nodes[i].ip.c_str(), nodes[i].port), key);
+            }
+            catch (std::logic_error&)
+            {
+                ok = false;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            // answers arriving after the decision must not change it
+            if (!decided)
+            {
+                valid[i] = ok;
+                keys[i] = key;
+            }
+            finished++;
+            changed.notify_all();
+        });
+    }
+    FanoutReport decision;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return decide(policy, valid, keys, finished == nodes.size(), decision); });
+        decided = true;
+    }
+    // every worker ends at the socket timeout at the latest
+    for (auto& worker : workers) worker.join();
+    if (report) *report = decision;
+    return decision.winner;
+}
+
+// Tells which node answered, false (after saying why) if there is no answer to print
+static bool printReport(const std::vector<NodeAddress>& nodes, FanoutPolicy policy, const FanoutReport& report)
+{
+    if (report.winner < 0)
+    {
+        if (report.answered == 0)
+            LOG("None of %d nodes returned a valid answer\n", int(nodes.size()));
+        else
+            LOG("No majority: at most %d/%d nodes agree (%d answered)\n", report.agreeing, int(nodes.size()), report.answered);
+        return false;
+    }
+    auto& node = nodes[report.winner];
+    if (policy == FANOUT_MAJORITY)
+        LOG("Answer from %s:%d, %d/%d nodes agree\n", node.ip.c_str(), node.port, report.agreeing, int(nodes.size()));
+    else
+        LOG("Answer from %s:%d (fastest)\n", node.ip.c_str(), node.port);
+    return true;
+}
+
+void printTickInfoFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy)
+{
+    CurrentTickInfo info;
+    FanoutReport report;
+    fanoutQuery<CurrentTickInfo>(nodes, policy,
+        [](QCPtr qc, CurrentTickInfo& out)
+        {
+            out = getTickInfoFromNode(qc);
+            return out.epoch != 0;
+        },
+        [](const CurrentTickInfo& a)
+        {
+            // aligned/misaligned vote counts keep changing during a tick, only tick and epoch must match
+            return bytesKey(&a.tick, sizeof(a.tick)) + bytesKey(&a.epoch, sizeof(a.epoch));
+        },
+        info, &report);
+    if (!printReport(nodes, policy, report)) cliExit(1);
+    printTickInfo(info);
+}
+
+void printBalanceFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy, const char* publicIdentity)
+{
+    uint8_t publicKey[32] = {0};
+    getPublicKeyFromIdentity(publicIdentity, publicKey);
+    RespondedEntity entity;
+    FanoutReport report;
+    fanoutQuery<RespondedEntity>(nodes, policy,
+        [&publicKey](QCPtr qc, RespondedEntity& out)
+        {
+            out = getBalance(qc, publicKey);
+            return out.tick != 0;
+        },
+        [](const RespondedEntity& a)
+        {
+            // the tick of the answer differs between nodes even when the entity does not
+            return bytesKey(&a.entity, sizeof(a.entity));
+        },
+        entity, &report);
+    if (!printReport(nodes, policy, report)) cliExit(1);
+    printEntity(publicIdentity, entity);
+}
+
+void getTickDataToFileFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy, uint32_t requestedTick, const char* fileName)
+{
+    std::unique_ptr<TickData> td(new TickData());
+    FanoutReport report;
+    fanoutQuery<TickData>(nodes, policy,
+        [requestedTick](QCPtr qc, TickData& out)
+        {
+            // false for an empty tick as well
+            return getTickDataFromNode(qc, requestedTick, out) && out.epoch != 0 && out.tick == requestedTick;
+        },
+        [](const TickData& a)
+        {
+            return bytesKey(&a, sizeof(TickData));
+        },
+        *td, &report);
+    if (!printReport(nodes, policy, report))
+    {
+        if (report.answered == 0)
+        {
+            LOG("Tick %u is empty\n", requestedTick);
+            return;
+        }
+        cliExit(1);
+    }
+    // transactions come from the node whose tick data was picked
+    auto qc = make_qc(nodes[report.winner].ip.c_str(), nodes[report.winner].port);
+    writeTickDataToFile(qc, *td, fileName);
+}
+
+void printQxFeeFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy)
+{
+    QxFees_output fees;
+    FanoutReport report;
+    fanoutQuery<QxFees_output>(nodes, policy,
+        [](QCPtr qc, QxFees_output& out)
+        {
+            getQxFees(qc, out);
+            QxFees_output zero;
+            memset(&zero, 0, sizeof(zero));
+            return memcmp(&out, &zero, sizeof(zero)) != 0;
+        },
+        [](const QxFees_output& a)
+        {
+            return bytesKey(&a, sizeof(a));
+        },
+        fees, &report);
+    if (!printReport(nodes, policy, report)) cliExit(1);
+    printQxFee(fees);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "connection.h"
+
+enum FanoutPolicy
+{
+    FANOUT_FASTEST = 0,  // first valid answer wins
+    FANOUT_MAJORITY = 1, // the answer more than half of the nodes agree on wins, none if there is no such answer
+};
+
+struct NodeAddress
+{
+    std::string ip;
+    int port;
+};
+
+// Parses "ip[:port],ip[:port],..." - nodes without a port use defaultPort
+std::vector<NodeAddress> parseNodeList(const char* nodeList, int defaultPort);
+// Parses "fastest" or "majority", exits on anything else
+FanoutPolicy parseFanoutPolicy(const char* policy);
+
+struct FanoutReport
+{
+    int winner;       // index of the node whose answer was returned, -1 if no valid answer (or no majority)
+    int agreeing;     // number of nodes that returned the same answer as the winner (the most common one if no majority)
+    int answered;     // number of nodes that returned a valid answer before the decision was made
+};
+
+// Asks every node at once, each on its own thread that is joined before returning, and picks an answer according
+// to policy. ask runs on the thread of node i with a make_qc connection to it, so -record, -replay and -nodelist
+// apply as for a single node. It returns false if the answer is not usable (no answer, stale, empty...),
+// otherwise it sets key to the bytes that must be equal for two nodes to agree. ask is not called again once the
+// decision is made, nodes still busy then are waited for but their answers are ignored.
+// Returns the index of the winner, -1 if no valid answer or, for FANOUT_MAJORITY, no majority.
+int fanoutRequest(const std::vector<NodeAddress>& nodes, FanoutPolicy policy,
+                  std::function<bool(size_t, QCPtr, std::string&)> ask, FanoutReport* report = nullptr);
+
+// fanoutRequest for answers read as T. query asks one node with the usual helper (getTickInfoFromNode,
+// getBalance...) and returns false if the answer is not usable, agreementKey maps an answer to the bytes that
+// must be equal for two nodes to agree.
+template <typename T>
+bool fanoutQuery(const std::vector<NodeAddress>& nodes, FanoutPolicy policy,
+                 std::function<bool(QCPtr, T&)> query,
+                 std::function<std::string(const T&)> agreementKey,
+                 T& result, FanoutReport* report = nullptr)
+{
+    std::vector<std::unique_ptr<T>> answers(nodes.size());
+    int winner = fanoutRequest(nodes, policy,
+        [&](size_t i, QCPtr qc, std::string& key)
+        {
+            std::unique_ptr<T> answer(new T());
+            if (!query(qc, *answer)) return false;
+            key = agreementKey(*answer);
+            answers[i] = std::move(answer);
+            return true;
+        }, report);
+    if (winner < 0) return false;
+    result = *answers[winner];
+    return true;
+}
+
+void printTickInfoFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy);
+void printBalanceFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy, const char* publicIdentity);
+void getTickDataToFileFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy, uint32_t requestedTick, const char* fileName);
+void printQxFeeFanout(const std::vector<NodeAddress>& nodes, FanoutPolicy policy);
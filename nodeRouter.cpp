@@ -0,0 +1,230 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "nodeRouter.h"
+#include "nodeDiscovery.h"
+#include "logger.h"
+
+namespace
+{
+    struct RoutedNode
+    {
+        NodeAddress address;
+        double rttMs; // moving average, negative until the first sample
+        uint32_t tick;
+        bool up;
+    };
+
+    struct Router
+    {
+        std::mutex lock;
+        bool enabled = false;
+        std::string routedKey;
+        std::vector<RoutedNode> nodes;
+        int current = -1;
+        bool probed = false;
+        bool probing = false;         // a thread is probing without holding the lock
+        unsigned int generation = 0;  // changes with the node list, results of older probes are dropped
+        std::condition_variable probeDone;
+        std::chrono::steady_clock::time_point lastProbe;
+    };
+
+    Router& getRouter()
+    {
+        static Router router;
+        return router;
+    }
+
+    std::string nodeKey(const char* nodeIp, int nodePort)
+    {
+        return std::string(nodeIp) + ":" + std::to_string(nodePort);
+    }
+
+    void selectNode(Router& router)
+    {
+        uint32_t bestTick = 0;
+        for (auto& node : router.nodes)
+        {
+            if (node.up && node.tick > bestTick) bestTick = node.tick;
+        }
+        auto usable = [bestTick](const RoutedNode& node)
+        {
+            return node.up && node.tick + ROUTER_MAX_TICK_LAG >= bestTick;
+        };
+        int best = -1;
+        for (int i = 0; i < int(router.nodes.size()); i++)
+        {
+            if (usable(router.nodes[i]) && (best < 0 || router.nodes[i].rttMs < router.nodes[best].rttMs)) best = i;
+        }
+        int previous = router.current;
+        if (previous >= 0 && usable(router.nodes[previous]) && best >= 0
+            && router.nodes[best].rttMs >= router.nodes[previous].rttMs * ROUTER_SWITCH_RATIO)
+        {
+            return; // not worth leaving the sessions already open
+        }
+        router.current = best;
+        if (best < 0 || best == previous) return;
+        auto& node = router.nodes[best];
+        // stdout is the output of the command, parsed by scripts and answered by the daemon
+        if (previous < 0)
+        {
+            fprintf(stderr, "Using node %s:%d (rtt %.1fms, tick %u)\n", node.address.ip.c_str(), node.address.port, node.rttMs, node.tick);
+            return;
+        }
+        auto& old = router.nodes[previous];
+        const char* reason = !old.up ? "unreachable" : (!usable(old) ? "behind on tick" : "slower");
+        fprintf(stderr, "Switching from node %s:%d (%s) to %s:%d (rtt %.1fms, tick %u)\n", old.address.ip.c_str(), old.address.port, reason,
+            node.address.ip.c_str(), node.address.port, node.rttMs, node.tick);
+    }
+
+    // Probes take up to a connect timeout, so the lock is released meanwhile and the other threads
+    // keep using the current node (or wait for this probe if there is none yet)
+    void probeAll(Router& router, std::unique_lock<std::mutex>& guard)
+    {
+        router.probing = true;
+        unsigned int generation = router.generation;
+        std::vector<NodeAddress> addresses;
+        for (auto& node : router.nodes) addresses.push_back(node.address);
+        guard.unlock();
+        std::vector<DiscoveredNode> results;
+        try
+        {
+            results = probeNodes(addresses, 0);
+        }
+        catch (std::logic_error&)
+        {
+            guard.lock();
+            router.probing = false;
+            router.probeDone.notify_all();
+            throw;
+        }
+        guard.lock();
+        router.probing = false;
+        router.probeDone.notify_all();
+        if (generation != router.generation) return;
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& node = router.nodes[i];
+            node.up = results[i].reachable;
+            if (!node.up) continue;
+            node.tick = results[i].tick;
+            double rtt = results[i].connectMs + results[i].rttMs;
+            node.rttMs = node.rttMs < 0 ? rtt : node.rttMs + ROUTER_RTT_SMOOTHING * (rtt - node.rttMs);
+        }
+        router.probed = true;
+        router.lastProbe = std::chrono::steady_clock::now();
+        selectNode(router);
+    }
+
+    // Waits for probe results that are not older than ROUTER_REFRESH_MS, probing if no other thread does.
+    // With noneLeft, results in which every node failed are refreshed once as well
+    void ensureProbed(Router& router, std::unique_lock<std::mutex>& guard, bool noneLeft)
+    {
+        bool reprobe = noneLeft && router.probed && router.current < 0;
+        while (reprobe || !router.probed
+               || std::chrono::steady_clock::now() - router.lastProbe > std::chrono::milliseconds(ROUTER_REFRESH_MS))
+        {
+            if (!router.probing)
+            {
+                probeAll(router, guard);
+                reprobe = false;
+                continue;
+            }
+            if (router.probed && !reprobe) break; // refreshed by another thread, the current node is good until then
+            router.probeDone.wait(guard);
+            reprobe = false;
+        }
+    }
+
+    // The current node failed: it is marked down unless the node list or the choice changed meanwhile
+    void markDown(Router& router, int index, unsigned int generation)
+    {
+        if (generation != router.generation || router.current != index) return;
+        router.nodes[index].up = false;
+        selectNode(router);
+    }
+}
+
+void enableNodeRouting(const std::vector<NodeAddress>& nodes, const char* routedIp, int routedPort)
+{
+    Router& router = getRouter();
+    std::lock_guard<std::mutex> guard(router.lock);
+    router.enabled = true;
+    router.routedKey = nodeKey(routedIp, routedPort);
+    router.nodes.clear();
+    for (auto& address : nodes)
+    {
+        RoutedNode node;
+        node.address = address;
+        node.rttMs = -1;
+        node.tick = 0;
+        node.up = false;
+        router.nodes.push_back(node);
+    }
+    router.current = -1;
+    router.probed = false;
+    router.generation++;
+}
+
+bool isRoutedNode(const char* nodeIp, int nodePort)
+{
+    Router& router = getRouter();
+    std::lock_guard<std::mutex> guard(router.lock);
+    if (!router.enabled) return false;
+    std::string key = nodeKey(nodeIp, nodePort);
+    if (key == router.routedKey) return true;
+    for (auto& node : router.nodes)
+    {
+        if (nodeKey(node.address.ip.c_str(), node.address.port) == key) return true;
+    }
+    return false;
+}
+
+QCPtr makeRoutedConnection()
+{
+    Router& router = getRouter();
+    std::unique_lock<std::mutex> guard(router.lock);
+    ensureProbed(router, guard, true);
+    for (size_t attempt = 0; attempt < router.nodes.size(); attempt++)
+    {
+        if (router.current < 0) break;
+        int current = router.current;
+        unsigned int generation = router.generation;
+        NodeAddress address = router.nodes[current].address;
+        // connecting may also take a timeout, the lock is only needed to pick the node
+        guard.unlock();
+        try
+        {
+            QCPtr qc = makePooledConnection(address.ip.c_str(), address.port);
+            qc->setRouted(true);
+            return qc;
+        }
+        catch (std::logic_error&)
+        {
+        }
+        guard.lock();
+        markDown(router, current, generation);
+    }
+    throw std::logic_error("No connection.");
+}
+
+bool failOverRoutedNode(const char* failedIp, int failedPort, NodeAddress& next)
+{
+    Router& router = getRouter();
+    std::unique_lock<std::mutex> guard(router.lock);
+    std::string failed = nodeKey(failedIp, failedPort);
+    for (int i = 0; i < int(router.nodes.size()); i++)
+    {
+        if (nodeKey(router.nodes[i].address.ip.c_str(), router.nodes[i].address.port) == failed)
+        {
+            markDown(router, i, router.generation);
+        }
+    }
+    ensureProbed(router, guard, true);
+    if (router.current < 0) return false;
+    next = router.nodes[router.current].address;
+    return nodeKey(next.ip.c_str(), next.port) != failed;
+}
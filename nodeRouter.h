@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "connection.h"
+#include "nodeFanout.h"
+
+#define ROUTER_REFRESH_MS 60000  // probe results are reused for this long, or until no usable node is left
+#define ROUTER_MAX_TICK_LAG 3    // nodes further behind the highest tick are not used
+#define ROUTER_RTT_SMOOTHING 0.3 // weight of a new RTT sample in the moving average
+#define ROUTER_SWITCH_RATIO 0.7  // a healthy current node is only left for one at least 30% faster
+
+// Sends the connections of make_qc(routedIp, routedPort), and of any node in nodes, to the node
+// with the lowest average RTT among those that are up to date on tick. All nodes are probed
+// concurrently on first use, the results are reused until they are ROUTER_REFRESH_MS old or every
+// node failed. A node that refuses a connection, or goes away in the middle of a request, is replaced
+// by the next best one mid-run. Node switches are reported on stderr, stdout stays the command output.
+void enableNodeRouting(const std::vector<NodeAddress>& nodes, const char* routedIp, int routedPort);
+bool isRoutedNode(const char* nodeIp, int nodePort);
+// Pooled connection to the current best node, throws if none of them can be reached
+QCPtr makeRoutedConnection();
+// Called by a routed connection that lost failedIp:failedPort and could not connect to it again: marks the node
+// down and returns the next best one in next, false if none is left
+bool failOverRoutedNode(const char* failedIp, int failedPort, NodeAddress& next);
@@ -14,8 +14,11 @@
 #include "keyUtils.h"
 #include "walletUtils.h"
 #include "qubicLogParser.h"
+#include "nodeDiscovery.h"
+#include "txIndex.h"
+#include "tickVerifier.h"
 
-static CurrentTickInfo getTickInfoFromNode(QCPtr qc)
+CurrentTickInfo getTickInfoFromNode(QCPtr qc)
 {
     CurrentTickInfo result;
     memset(&result, 0, sizeof(CurrentTickInfo));
@@ -27,7 +30,7 @@ static CurrentTickInfo getTickInfoFromNode(QCPtr qc)
     packet.header.setType(REQUEST_CURRENT_TICK_INFO);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RESPOND_CURRENT_TICK_INFO});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -47,16 +50,20 @@ uint32_t getTickNumberFromNode(QCPtr qc)
     auto curTickInfo = getTickInfoFromNode(qc);
     return curTickInfo.tick;
 }
+void printTickInfo(const CurrentTickInfo& curTickInfo)
+{
+    LOG("Tick: %u\n", curTickInfo.tick);
+    LOG("Epoch: %u\n", curTickInfo.epoch);
+    LOG("Number Of Aligned Votes: %u\n", curTickInfo.numberOfAlignedVotes);
+    LOG("Number Of Misaligned Votes: %u\n", curTickInfo.numberOfMisalignedVotes);
+    LOG("Initial tick: %u\n", curTickInfo.initialTick);
+}
 void printTickInfoFromNode(const char* nodeIp, int nodePort)
 {
     auto qc = make_qc(nodeIp, nodePort);
     auto curTickInfo = getTickInfoFromNode(qc);
     if (curTickInfo.epoch != 0){
-        LOG("Tick: %u\n", curTickInfo.tick);
-        LOG("Epoch: %u\n", curTickInfo.epoch);
-        LOG("Number Of Aligned Votes: %u\n", curTickInfo.numberOfAlignedVotes);
-        LOG("Number Of Misaligned Votes: %u\n", curTickInfo.numberOfMisalignedVotes);
-        LOG("Initial tick: %u\n", curTickInfo.initialTick);
+        printTickInfo(curTickInfo);
     } else {
         LOG("Error while getting tick info from %s:%d\n", nodeIp, nodePort);
     }
@@ -74,7 +81,7 @@ static CurrentSystemInfo getSystemInfoFromNode(QCPtr qc)
     packet.header.setType(REQUEST_SYSTEM_INFO);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RESPOND_SYSTEM_INFO});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -101,7 +108,7 @@ void printSystemInfoFromNode(const char* nodeIp, int nodePort)
         LOG("LatestCreatedTick: %u\n", curSystemInfo.latestCreatedTick);
         LOG("NumberOfEntities: %u\n", curSystemInfo.numberOfEntities);
         LOG("NumberOfTransactions: %u\n", curSystemInfo.numberOfTransactions);
-        char hex[64];
+        char hex[65];
         byteToHex(curSystemInfo.randomMiningSeed, hex, 32);
         LOG("RandomMiningSeed: %s\n", hex);
         LOG("SolutionThreshold: %u\n", curSystemInfo.solutionThreshold);
@@ -113,7 +120,8 @@ void printSystemInfoFromNode(const char* nodeIp, int nodePort)
     }
 }
 
-static void getTickTransactions(QubicConnection* qc, const uint32_t requestedTick, int nTx,
+// Requests the transactions whose digest bit is set in digestBitmap
+static void getTickTransactions(QubicConnection* qc, const uint32_t requestedTick, const uint8_t* digestBitmap,
                                 std::vector<Transaction>& txs, //out
                                 std::vector<TxhashStruct>* hashes, //out
                                 std::vector<extraDataStruct>* extraData, // out
@@ -142,19 +150,14 @@ static void getTickTransactions(QubicConnection* qc, const uint32_t requestedTic
     packet.header.randomizeDejavu();
     packet.header.setType(REQUEST_TICK_TRANSACTIONS); // REQUEST_TICK_TRANSACTIONS
     packet.txs.tick = requestedTick;
-    for (int i = 0; i < (nTx+7)/8; i++) packet.txs.transactionFlags[i] = 0;
-    for (int i = (nTx+7)/8; i < NUMBER_OF_TRANSACTIONS_PER_TICK/8; i++) packet.txs.transactionFlags[i] = 0xff;
+    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK/8; i++) packet.txs.transactionFlags[i] = ~digestBitmap[i];
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = buffer.size();
-    int ptr = 0;
-    while (ptr < recvByte)
+    ReceiveBuffer buffer;
+    qc->receiveDataUntil(buffer, {END_RESPONSE});
+    for (auto& response : splitPackets(buffer.data(), buffer.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == BROADCAST_TRANSACTION){
-            auto tx = (Transaction *)(data + ptr + sizeof(RequestResponseHeader));
+        auto tx = response.type() == BROADCAST_TRANSACTION ? response.as<Transaction>() : nullptr;
+        if (tx && response.payloadSize() >= sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE){
             txs.push_back(*tx);
             if (hashes != nullptr){
                 TxhashStruct hash;
@@ -182,14 +185,13 @@ static void getTickTransactions(QubicConnection* qc, const uint32_t requestedTic
                 sigs->push_back(sig);
             }
         }
-        ptr+= header->size();
     }
 
 }
-static void getTickData(const char* nodeIp, const int nodePort, const uint32_t tick, TickData& result)
+// Returns the tick data read in place from buffer, nullptr if the node has none for this tick
+static const TickData* getTickData(QubicConnection* qc, const uint32_t tick, ReceiveBuffer& buffer)
 {
-    memset(&result, 0, sizeof(TickData));
-    static struct
+    struct
     {
         RequestResponseHeader header;
         RequestTickData requestTickData;
@@ -198,23 +200,29 @@ static void getTickData(const char* nodeIp, const int nodePort, const uint32_t t
     packet.header.randomizeDejavu();
     packet.header.setType(REQUEST_TICK_DATA);
     packet.requestTickData.requestedTickData.tick = tick;
-    auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = buffer.size();
-    int ptr = 0;
-    while (ptr < recvByte)
+    qc->receiveDataUntil(buffer, {BROADCAST_FUTURE_TICK_DATA, END_RESPONSE});
+    const TickData* result = nullptr;
+    for (auto& response : splitPackets(buffer.data(), buffer.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == BROADCAST_FUTURE_TICK_DATA){
-            auto curTickData = (TickData*)(data + ptr + sizeof(RequestResponseHeader));
-            result = *curTickData;
+        if (response.type() == BROADCAST_FUTURE_TICK_DATA && response.as<TickData>()){
+            result = response.as<TickData>();
         }
-        ptr+= header->size();
     }
+    return result;
+}
 
+bool getTickDataFromNode(QCPtr qc, const uint32_t tick, TickData& result)
+{
+    ReceiveBuffer buffer;
+    const TickData* td = getTickData(qc.get(), tick, buffer);
+    if (!td)
+    {
+        memset(&result, 0, sizeof(TickData));
+        return false;
+    }
+    result = *td;
+    return true;
 }
 
 int getMoneyFlewStatus(QubicConnection* qc, const char* txHash, const uint32_t requestedTick)
@@ -228,39 +236,38 @@ int getMoneyFlewStatus(QubicConnection* qc, const char* txHash, const uint32_t r
     packet.header.setType(REQUEST_TX_STATUS); // REQUEST_TX_STATUS
     packet.rts.tick = requestedTick;
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    std::vector<uint8_t> buffer;
+    ReceiveBuffer buffer;
     try{
-        qc->receiveDataAll(buffer);
+        qc->receiveDataUntil(buffer, {RESPOND_TX_STATUS});
     }
     catch (std::logic_error& e) {
         // it's expected to catch this error on some node that not turn on tx status
         return -1;
     }
 
-    uint8_t* data = buffer.data();
-    int recvByte = buffer.size();
-    int ptr = 0;
-    RespondTxStatus result;
-    memset(&result, 0, sizeof(result));
-    while (ptr < recvByte)
+    const RespondTxStatus* result = nullptr;
+    for (auto& response : splitPackets(buffer.data(), buffer.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == RESPOND_TX_STATUS){
+        if (response.type() == RESPOND_TX_STATUS){
             // notice: the node not always return full size of RESPOND_TX_STATUS
             // it only returns enough digests
-            auto ptr_rts = (RespondTxStatus *)(data + ptr + sizeof(RequestResponseHeader));
-            size_t received_size = ptr_rts->size();
-            memcpy(&result, ptr_rts, received_size);
+            auto rts = response.as<RespondTxStatus>(offsetof(RespondTxStatus, txDigests));
+            if (rts && rts->txCount <= NUMBER_OF_TRANSACTIONS_PER_TICK && response.payloadSize() >= rts->size())
+            {
+                result = rts;
+            }
             break;
         }
-        ptr+= header->size();
+    }
+    if (!result){
+        return -1;
     }
 
     int tx_id = -1;
-    for (int i = 0; i < result.txCount; i++){
+    for (int i = 0; i < result->txCount; i++){
         char tx_hash[60];
         memset(tx_hash, 0, 60);
-        getIdentityFromPublicKey(result.txDigests[i], tx_hash, true);
+        getIdentityFromPublicKey(result->txDigests[i], tx_hash, true);
         if (memcmp(tx_hash, txHash, 60) == 0){
             tx_id = i;
             break;
@@ -269,12 +276,17 @@ int getMoneyFlewStatus(QubicConnection* qc, const char* txHash, const uint32_t r
     if (tx_id == -1){
         return -1; // not found !?
     }
-    return (result.moneyFlew[tx_id >> 3] & (1<<(tx_id & 7))) ? 1 : 0;
+    return (result->moneyFlew[tx_id >> 3] & (1<<(tx_id & 7))) ? 1 : 0;
 }
 
 bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, uint32_t requestedTick)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
+    return checkTxOnTick(qc, txHash, requestedTick);
+}
+
+bool checkTxOnTick(QCPtr qc, const char* txHash, uint32_t requestedTick)
+{
     // conditions:
     // - current Tick is higher than requested tick
     // - has tick data
@@ -285,23 +297,40 @@ bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, u
         LOG("Please wait a bit more. Requested tick %u, current tick %u\n", requestedTick, currenTick);
         return false;
     }
-    TickData td;
-    getTickData(nodeIp, nodePort, requestedTick, td);
-    if (td.epoch == 0)
+    ReceiveBuffer tickDataBuffer;
+    const TickData* td = getTickData(qc.get(), requestedTick, tickDataBuffer);
+    if (!td || td->epoch == 0)
     {
         LOG("Tick %u is empty\n", requestedTick);
         return false;
     }
-    int numTx = 0;
-    uint8_t all_zero[32] = {0};
-    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++){
-        if (memcmp(all_zero, td.transactionDigests[i], 32) != 0) numTx++;
+    // the tx hash is its digest, a tick that does not list it does not need its transactions fetched
+    uint8_t txDigest[32];
+    uint8_t digestBitmap[TICK_DIGEST_BITMAP_SIZE];
+    scanTransactionDigests(*td, digestBitmap);
+    bool listed = false;
+    if (getDigestFromTxHash(txHash, txDigest))
+    {
+        for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK && !listed; i++)
+        {
+            if (!(digestBitmap[i >> 3] & (1 << (i & 7)))) continue;
+            if (memcmp(td->transactionDigests[i], txDigest, 32) != 0) continue;
+            // only this one transaction is requested
+            memset(digestBitmap, 0, sizeof(digestBitmap));
+            digestBitmap[i >> 3] = 1 << (i & 7);
+            listed = true;
+        }
+    }
+    if (!listed)
+    {
+        LOG("Can NOT find tx %s on tick %u\n", txHash, requestedTick);
+        return false;
     }
     std::vector<Transaction> txs;
     std::vector<TxhashStruct> txHashesFromTick;
     std::vector<extraDataStruct> extraData;
     std::vector<SignatureStruct> signatureStruct;
-    getTickTransactions(qc.get(), requestedTick, numTx, txs, &txHashesFromTick, &extraData, &signatureStruct);
+    getTickTransactions(qc.get(), requestedTick, digestBitmap, txs, &txHashesFromTick, &extraData, &signatureStruct);
     for (int i = 0; i < txHashesFromTick.size(); i++)
     {
         if (memcmp(txHashesFromTick[i].hash, txHash, 60) == 0)
@@ -317,399 +346,227 @@ bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, u
     return false;
 }
 
-static void dumpQuorumTick(const Tick& A, bool dumpComputorIndex = true){
-    char digest[64] = {0};
-    if (dumpComputorIndex) LOG("Computor index: %d\n", A.computorIndex);
-    LOG("Epoch: %d\n", A.epoch);
-    LOG("Tick: %d\n", A.tick);
-    LOG("Time: 20%02u-%02u-%02u %02u:%02u:%02u.%04u\n", A.year, A.month, A.day, A.hour, A.minute, A.second, A.millisecond);
-    LOG("prevResourceTestingDigest: %llu\n", A.prevResourceTestingDigest);
-    getIdentityFromPublicKey(A.prevSpectrumDigest, digest, true);
-    LOG("prevSpectrumDigest: %s\n", digest);
-    getIdentityFromPublicKey(A.prevUniverseDigest, digest, true);
-    LOG("prevUniverseDigest: %s\n", digest);
-    getIdentityFromPublicKey(A.prevComputerDigest, digest, true);
-    LOG("prevComputerDigest: %s\n", digest);
-    getIdentityFromPublicKey(A.transactionDigest, digest, true);
-    LOG("transactionDigest: %s\n", digest);
-    getIdentityFromPublicKey(A.expectedNextTickTransactionDigest, digest, true);
-    LOG("expectedNextTickTransactionDigest: %s\n", digest);
-}
-bool compareVote(const Tick&A, const Tick&B){
-    return (A.epoch == B.epoch) && (A.tick == B.tick) &&
-           (A.year == B.year) && (A.month == B.month) && (A.day == B.day) && (A.hour == B.hour) && (A.minute == B.minute) && (A.second == B.second) &&
-           (A.millisecond == B.millisecond) &&
-           (A.prevResourceTestingDigest == B.prevResourceTestingDigest) &&
-           (memcmp(A.prevSpectrumDigest, B.prevSpectrumDigest, 32) == 0) &&
-           (memcmp(A.prevUniverseDigest, B.prevUniverseDigest, 32) == 0) &&
-           (memcmp(A.prevComputerDigest, B.prevComputerDigest, 32) == 0) &&
-           (memcmp(A.transactionDigest, B.transactionDigest, 32) == 0) &&
-           (memcmp(A.expectedNextTickTransactionDigest, B.expectedNextTickTransactionDigest, 32) == 0);
-}
-
-bool verifyVoteWithSalt(const Tick&A,
-                        const BroadcastComputors& bc,
-                        const long long prevResourceDigest,
-                        const uint8_t* prevSpectrumDigest,
-                        const uint8_t* prevUniverseDigest,
-                        const uint8_t* prevComputerDigest){
-    int cid = A.computorIndex;
-    uint8_t saltedData[64];
-    uint8_t saltedDigest[32];
-    memset(saltedData, 0, 64);
-    memcpy(saltedData, bc.computors.publicKeys[cid], 32);
-    memcpy(saltedData+32, &prevResourceDigest, 8);
-    KangarooTwelve(saltedData, 40, saltedDigest, 8);
-    if (A.saltedResourceTestingDigest != *((unsigned long long*)(saltedDigest))){
-        LOG("Mismatched saltedResourceTestingDigest. Computor index: %d\n", cid);
-        return false;
-    }
-    memcpy(saltedData+32, prevSpectrumDigest, 32);
-    KangarooTwelve(saltedData, 64, saltedDigest, 32);
-    if (memcmp(saltedDigest, A.saltedSpectrumDigest, 32) != 0)
+// Fills the transactions of result from its tick data
+static void fetchTickTransactions(QCPtr qc, FetchedTick& result)
+{
+    result.transactions.clear();
+    if (result.tickData.numTx() == 0) return;
+    std::vector<Transaction> txs;
+    std::vector<extraDataStruct> extraData;
+    std::vector<SignatureStruct> signatures;
+    getTickTransactions(qc.get(), result.tickData.header.tick, result.tickData.digestBitmap, txs, nullptr, &extraData, &signatures);
+    for (int i = 0; i < txs.size(); i++)
     {
-        LOG("Mismatched saltedSpectrumDigest. Computor index: %d\n", cid);
-        return false;
+        std::vector<uint8_t> raw(sizeof(Transaction) + txs[i].inputSize + SIGNATURE_SIZE);
+        memcpy(raw.data(), &txs[i], sizeof(Transaction));
+        if (txs[i].inputSize != 0){
+            memcpy(raw.data() + sizeof(Transaction), extraData[i].vecU8.data(), txs[i].inputSize);
+        }
+        memcpy(raw.data() + sizeof(Transaction) + txs[i].inputSize, signatures[i].sig, SIGNATURE_SIZE);
+        result.transactions.push_back(raw);
     }
+}
 
-    memcpy(saltedData+32, prevUniverseDigest, 32);
-    KangarooTwelve(saltedData, 64, saltedDigest, 32);
-    if (memcmp(saltedDigest, A.saltedUniverseDigest, 32) != 0)
+TickFetchResult fetchTickFromNode(QCPtr qc, uint32_t tick, uint32_t currentTick, FetchedTick& result)
+{
+    result.transactions.clear();
+    if (currentTick < tick)
     {
-        LOG("Mismatched saltedUniverseDigest. Computor index: %d\n", cid);
-        return false;
+        return TICK_NOT_REACHED;
     }
-
-    memcpy(saltedData+32, prevComputerDigest, 32);
-    KangarooTwelve(saltedData, 64, saltedDigest, 32);
-    if (memcmp(saltedDigest, A.saltedComputerDigest, 32) != 0)
+    ReceiveBuffer tickDataBuffer;
+    const TickData* td = getTickData(qc.get(), tick, tickDataBuffer);
+    if (!td || td->epoch == 0)
     {
-        LOG("Mismatched saltedComputerDigest. Computor index: %d\n", cid);
-        return false;
-    }
-    return true;
-}
-
-std::string indexToAlphabet(int index){
-    std::string result = "";
-    result += char('A' + (index/26));
-    result += char('A' + (index%26));
-    return result;
+        memset(&result.tickData.header, 0, sizeof(TickDataHeader));
+        memset(result.tickData.digestBitmap, 0, TICK_DIGEST_BITMAP_SIZE);
+        result.tickData.digests.clear();
+        result.tickData.fees.clear();
+        return TICK_EMPTY;
+    }
+    toSparseTickData(*td, result.tickData);
+    fetchTickTransactions(qc, result);
+    return TICK_FETCHED;
 }
 
-void getUniqueVotes(std::vector<Tick>& votes, std::vector<Tick>& uniqueVote, std::vector<std::vector<int>>& voteIndices, int N,
-                    bool verifySalt = false,
-                    BroadcastComputors* pBC = nullptr,
-                    const long long prevResourceDigest = 0,
-                    const uint8_t* prevSpectrumDigest = nullptr,
-                    const uint8_t* prevUniverseDigest = nullptr,
-                    const uint8_t* prevComputerDigest = nullptr
-)
+void writeFetchedTick(FILE* f, const FetchedTick& tick)
 {
-    if (votes.size() == 0) return;
-    if (verifySalt)
+    std::unique_ptr<TickData> td(new TickData);
+    fromSparseTickData(tick.tickData, *td);
+    fwrite(td.get(), 1, sizeof(TickData), f);
+    for (auto& tx : tick.transactions)
     {
-        std::vector<Tick> new_votes;
-        LOG("Performing salt check...\n");
-        bool all_passed = true;
-        for (int i = 0; i < N; i++)
-        {
-            if (!verifyVoteWithSalt(votes[i], *pBC, prevResourceDigest, prevSpectrumDigest, prevUniverseDigest, prevComputerDigest)){
-                LOG("Vote %d failed to pass salt check\n", i);
-                dumpQuorumTick(votes[i]);
-                all_passed = false;
-            } else {
-                new_votes.push_back(votes[i]);
-            }
-        }
-        if (all_passed){
-            LOG("ALL votes PASSED salts check\n");
-        } else {
-            votes = new_votes;
-        }
-    }
-    uniqueVote.resize(0);
-    uniqueVote.push_back(votes[0]);
-    voteIndices.resize(1);
-    voteIndices[0].push_back(votes[0].computorIndex);
-    for (int i = 1; i < votes.size(); i++){
-        int vote_indice = -1;
-        for (int j = 0; j < uniqueVote.size(); j++){
-            if (compareVote(votes[i], uniqueVote[j])){
-                vote_indice = j;
-                break;
-            }
-        }
-        if (vote_indice != -1){
-            voteIndices[vote_indice].push_back(votes[i].computorIndex);
-        } else {
-            uniqueVote.push_back(votes[i]);
-            voteIndices.resize(voteIndices.size() + 1);
-            int M = voteIndices.size() -1;
-            voteIndices[M].resize(0);
-            voteIndices[M].push_back(votes[i].computorIndex);
-        }
+        fwrite(tx.data(), 1, tx.size(), f);
     }
 }
 
-void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName)
+bool verifyTickSignature(const SparseTickData& td, const ComputorList& computors)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
-    BroadcastComputors bc;
-    {
-        FILE* f = fopen(compFileName, "rb");
-        if (fread(&bc, 1, sizeof(BroadcastComputors), f) != sizeof(BroadcastComputors)){
-            LOG("Failed to read comp list\n");
-            fclose(f);
-            return;
-        }
-        fclose(f);
-    }
-
-    static struct
-    {
-        RequestResponseHeader header;
-        RequestedQuorumTick rqt;
-    } packet;
-    packet.header.setSize(sizeof(packet));
-    packet.header.randomizeDejavu();
-    packet.header.setType(RequestedQuorumTick::type); // REQUEST_TICK_DATA
-    packet.rqt.tick = requestedTick;
-    memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
-    qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
-    auto votes = qc->getLatestVectorPacketAs<Tick>();
-    LOG("Received %d quorum tick #%u (votes)\n", votes.size(), requestedTick);
-
-    packet.rqt.tick = requestedTick+1;
-    memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
-    qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
-    auto votes_next = qc->getLatestVectorPacketAs<Tick>();
-    LOG("Received %d quorum tick #%u (votes)\n", votes_next.size(), requestedTick+1);
-
-    int N = votes.size();
-    if (N == 0){
-        return;
-    }
+    if (td.header.computorIndex >= NUMBER_OF_COMPUTORS) return false;
+    std::unique_ptr<TickData> full(new TickData);
+    fromSparseTickData(td, *full);
+    uint8_t digest[32];
+    full->computorIndex ^= BROADCAST_FUTURE_TICK_DATA;
+    KangarooTwelve(reinterpret_cast<const uint8_t *>(full.get()),
+                   sizeof(TickData) - SIGNATURE_SIZE,
+                   digest,
+                   32);
+    return verifyComputorSignature(computors, td.header.computorIndex, digest, td.signature);
+}
 
-    for (int i = 0; i < N; i++){
-        uint8_t digest[64] = {0};
-        votes[i].computorIndex ^= Tick::type();
-        KangarooTwelve((uint8_t*)&votes[i], sizeof(Tick) - SIGNATURE_SIZE, digest, 32);
-        votes[i].computorIndex ^= Tick::type();
-        int comp_index = votes[i].computorIndex;
-        if (!verify(bc.computors.publicKeys[comp_index], digest, votes[i].signature)){
-            LOG("Signature of vote %d is not correct\n", i);
-            dumpQuorumTick(votes[i]);
-            return;
-        }
-    }
-    std::vector<Tick> uniqueVote, uniqueVoteNext;
-    std::vector<std::vector<int>> voteIndices, voteIndicesNext;
-    getUniqueVotes(votes_next, uniqueVoteNext, voteIndicesNext, N);
-    if (votes_next.size() < 451)
+TickVerifyResult verifyFetchedTick(const FetchedTick& tick, const ComputorList& computors)
+{
+    if (!verifyTickSignature(tick.tickData, computors))
     {
-        printf("Failed to get votes for tick %d, this will not perform salt check\n", requestedTick+1);
-        getUniqueVotes(votes, uniqueVote, voteIndices, N);
-    }
-    else
+        return TICK_BAD_SIGNATURE;
+    }
+    // the signed digests vouch for the transactions: each one has to be there, and nothing else
+    auto& digests = tick.tickData.digests;
+    int numTx = tick.tickData.numTx();
+    if (int(tick.transactions.size()) > numTx) return TICK_UNEXPECTED_TRANSACTIONS;
+    const uint8_t* announced[NUMBER_OF_TRANSACTIONS_PER_TICK];
+    bool received[NUMBER_OF_TRANSACTIONS_PER_TICK] = {false};
+    for (int i = 0; i < numTx; i++) announced[i] = digests.data() + i * 32;
+    auto digestLess = [](const uint8_t* a, const uint8_t* b) { return memcmp(a, b, 32) < 0; };
+    std::sort(announced, announced + numTx, digestLess);
+    uint8_t digest[32];
+    for (auto& tx : tick.transactions)
     {
-        int max_id = 0;
-        for (int i = 1; i < uniqueVote.size(); i++){
-            if (voteIndicesNext[max_id].size() < voteIndicesNext[i].size()){
-                max_id = i;
-            }
-        }
-        auto vote_next = uniqueVoteNext[max_id];
-        getUniqueVotes(votes, uniqueVote, voteIndices, N, true, &bc,
-                       vote_next.prevResourceTestingDigest,
-                       vote_next.prevSpectrumDigest,
-                       vote_next.prevUniverseDigest,
-                       vote_next.prevComputerDigest);
-    }
-
-
-
-    LOG("Number of unique votes: %d\n", uniqueVote.size());
-    for (int i = 0; i < uniqueVote.size(); i++){
-        LOG("Vote #%d (voted by %d computors ID) ", i, voteIndices[i].size());
-        const bool dumpComputorIndex = false;
-        dumpQuorumTick(uniqueVote[i], dumpComputorIndex);
-        LOG("Voted by: ");
-        std::sort(voteIndices[i].begin(), voteIndices[i].end());
-        for (int j = 0; j < voteIndices[i].size(); j++){
-            int index = voteIndices[i][j];
-            auto alphabet = indexToAlphabet(index);
-            if (j < voteIndices[i].size() - 1){
-                LOG("%d(%s), ", index, alphabet.c_str());
-            } else {
-                LOG("%d(%s)\n", index, alphabet.c_str());
-            }
-        }
-    }
+        KangarooTwelve(tx.data(), tx.size(), digest, 32);
+        // a digest announced twice takes two transactions, the first slot not taken yet is used
+        size_t i = std::lower_bound(announced, announced + numTx, (const uint8_t*)digest, digestLess) - announced;
+        while (i < size_t(numTx) && received[i] && memcmp(announced[i], digest, 32) == 0) i++;
+        if (i == size_t(numTx) || memcmp(announced[i], digest, 32) != 0) return TICK_UNEXPECTED_TRANSACTIONS;
+        received[i] = true;
+    }
+    if (int(tick.transactions.size()) < numTx) return TICK_MISSING_TRANSACTIONS;
+    return TICK_VERIFIED;
 }
 
 void getTickDataToFile(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* fileName)
 {
-    auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
+    auto qc = make_qc(nodeIp, nodePort);
     uint32_t currenTick = getTickNumberFromNode(qc);
-    if (currenTick < requestedTick)
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    switch (fetchTickFromNode(qc, requestedTick, currenTick, *fetched))
     {
-        LOG("Please wait a bit more. Requested tick %u, current tick %u\n", requestedTick, currenTick);
-        return;
-    }
-    TickData td;
-    getTickData(nodeIp, nodePort, requestedTick, td);
-    if (td.epoch == 0)
-    {
-        LOG("Tick %u is empty\n", requestedTick);
-        return;
-    }
-    int numTx = 0;
-    uint8_t all_zero[32] = {0};
-    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++){
-        if (memcmp(all_zero, td.transactionDigests[i], 32) != 0) numTx++;
+        case TICK_NOT_REACHED:
+            LOG("Please wait a bit more. Requested tick %u, current tick %u\n", requestedTick, currenTick);
+            return;
+        case TICK_EMPTY:
+            LOG("Tick %u is empty\n", requestedTick);
+            return;
+        case TICK_FETCHED:
+            break;
     }
-    std::vector<Transaction> txs;
-    std::vector<extraDataStruct> extraData;
-    std::vector<SignatureStruct> signatures;
-    getTickTransactions(qc.get(), requestedTick, numTx, txs, nullptr, &extraData, &signatures);
-
     FILE* f = fopen(fileName, "wb");
-    fwrite(&td, 1, sizeof(TickData), f);
-    for (int i = 0; i < txs.size(); i++)
-    {
-        fwrite(&txs[i], 1, sizeof(Transaction), f);
-        int extraDataSize = txs[i].inputSize;
-        if (extraDataSize != 0){
-            fwrite(extraData[i].vecU8.data(), 1, extraDataSize, f);
-        }
-        fwrite(signatures[i].sig, 1, SIGNATURE_SIZE, f);
-    }
+    writeFetchedTick(f, *fetched);
     fclose(f);
     LOG("Tick data and tick transactions have been written to %s\n", fileName);
 }
 
-void readTickDataFromFile(const char* fileName, TickData& td,
-                          std::vector<Transaction>& txs,
-                          std::vector<extraDataStruct>* extraData,
-                          std::vector<SignatureStruct>* signatures,
-                          std::vector<TxhashStruct>* txHashes)
+void writeTickDataToFile(QCPtr qc, const TickData& td, const char* fileName)
 {
-    uint8_t extraDataBuffer[1024] = {0};
-    uint8_t signatureBuffer[128] = {0};
-    char txHashBuffer[128] = {0};
-    uint8_t digest[32] = {0};
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    toSparseTickData(td, fetched->tickData);
+    fetchTickTransactions(qc, *fetched);
+    FILE* f = fopen(fileName, "wb");
+    writeFetchedTick(f, *fetched);
+    fclose(f);
+    LOG("Tick data and tick transactions have been written to %s\n", fileName);
+}
 
+bool readTickFile(const char* fileName, FetchedTick& result)
+{
+    result.transactions.clear();
     FILE* f = fopen(fileName, "rb");
-    fread(&td, 1, sizeof(TickData), f);
-    int numTx = 0;
-    uint8_t all_zero[32] = {0};
-    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++){
-        if (memcmp(all_zero, td.transactionDigests[i], 32) != 0) numTx++;
-    }
-    for (int i = 0; i < numTx; i++){
+    if (f == nullptr) return false;
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    for (size_t read; (read = fread(chunk, 1, sizeof(chunk), f)) > 0;) data.insert(data.end(), chunk, chunk + read);
+    fclose(f);
+    if (data.size() < sizeof(TickData)) return false;
+    std::unique_ptr<TickData> td(new TickData);
+    memcpy(td.get(), data.data(), sizeof(TickData));
+    toSparseTickData(*td, result.tickData);
+    size_t offset = sizeof(TickData);
+    for (int i = 0; i < result.tickData.numTx() && offset + sizeof(Transaction) <= data.size(); i++)
+    {
         Transaction tx;
-        fread(&tx, 1, sizeof(Transaction), f);
-        int extraDataSize = tx.inputSize;
-        if (extraData != nullptr){
-            extraDataStruct eds;
-            if (extraDataSize != 0){
-                fread(extraDataBuffer, 1, extraDataSize, f);
-                eds.vecU8.resize(extraDataSize);
-                memcpy(eds.vecU8.data(), extraDataBuffer, extraDataSize);
-            }
-            extraData->push_back(eds);
-        }
-
-        fread(signatureBuffer, 1, SIGNATURE_SIZE, f);
-        if (signatures != nullptr){
-            SignatureStruct sig;
-            memcpy(sig.sig, signatureBuffer, SIGNATURE_SIZE);
-            signatures->push_back(sig);
-        }
-        if (txHashes != nullptr){
-            std::vector<uint8_t> raw_data;
-            raw_data.resize(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
-            auto ptr = raw_data.data();
-            memcpy(ptr, &tx, sizeof(Transaction));
-            memcpy(ptr + sizeof(Transaction), extraDataBuffer, tx.inputSize);
-            memcpy(ptr + sizeof(Transaction) + tx.inputSize, signatureBuffer, SIGNATURE_SIZE);
-            KangarooTwelve(ptr,
-                           raw_data.size(),
-                           digest,
-                           32);
-            TxhashStruct tx_hash;
-            getTxHashFromDigest(digest, txHashBuffer);
-            memcpy(tx_hash.hash, txHashBuffer, 60);
-            txHashes->push_back(tx_hash);
-        }
-        txs.push_back(tx);
+        memcpy(&tx, data.data() + offset, sizeof(Transaction));
+        size_t txSize = sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE;
+        if (offset + txSize > data.size()) break;
+        result.transactions.push_back(std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + txSize));
+        offset += txSize;
     }
-    fclose(f);
+    return true;
 }
 
-BroadcastComputors readComputorListFromFile(const char* fileName);
-
-void printTickDataFromFile(const char* fileName, const char* compFile)
+void printTickDataFromFile(const char* fileName, const char* compFile, int jobs)
 {
-    TickData td;
-    std::vector<Transaction> txs;
-    std::vector<extraDataStruct> extraData;
-    std::vector<SignatureStruct> signatures;
-    std::vector<TxhashStruct> txHashes;
-    uint8_t digest[32];
-    readTickDataFromFile(fileName, td, txs, &extraData, &signatures, &txHashes);
-    //verifying everything
-    BroadcastComputors bc;
-    bc = readComputorListFromFile(compFile);
-    if (bc.computors.epoch != td.epoch){
-        LOG("Computor list epoch (%u) and tick data epoch (%u) are not matched\n", bc.computors.epoch, td.epoch);
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    if (!readTickFile(fileName, *fetched))
+    {
+        LOG("%s is not a tick data file\n", fileName);
+        return;
     }
-    int computorIndex = td.computorIndex;
-    td.computorIndex ^= BROADCAST_FUTURE_TICK_DATA;
-    KangarooTwelve(reinterpret_cast<const uint8_t *>(&td),
-                   sizeof(TickData) - SIGNATURE_SIZE,
-                   digest,
-                   32);
-    uint8_t* computorOfThisTick = bc.computors.publicKeys[computorIndex];
-    if (verify(computorOfThisTick, digest, td.signature)){
+    const TickDataHeader& td = fetched->tickData.header;
+    //verifying everything
+    ComputorListPtr computors = readComputorListFromFile(compFile);
+    if (!computors) return;
+    if (computors->epoch() != td.epoch){
+        LOG("Computor list epoch (%u) and tick data epoch (%u) are not matched\n", computors->epoch(), td.epoch);
+    }
+    TickAudit audit;
+    std::vector<TxCheck> checks;
+    auditTick(*fetched, *computors, jobs, audit, checks);
+    if (audit.signatureValid){
         LOG("Tick is VERIFIED (signed by correct computor).\n");
     } else {
         LOG("Tick is NOT verified (not signed by correct computor).\n");
     }
     LOG("Epoch: %u\n", td.epoch);
     LOG("Tick: %u\n", td.tick);
-    LOG("Computor index: %u\n", computorIndex);
+    LOG("Computor index: %u\n", td.computorIndex);
     LOG("Datetime: %u-%u-%u %u:%u:%u.%u\n", td.day, td.month, td.year, td.hour, td.minute, td.second, td.millisecond);
 
-    for (int i = 0; i < txs.size(); i++)
+    for (int i = 0; i < fetched->transactions.size(); i++)
     {
-        uint8_t* extraDataPtr = extraData[i].vecU8.empty() ? nullptr : extraData[i].vecU8.data();
-        printReceipt(txs[i], txHashes[i].hash, extraDataPtr);
-        if (verifyTx(txs[i], extraData[i].vecU8.data(), signatures[i].sig))
+        auto& raw = fetched->transactions[i];
+        Transaction tx;
+        memcpy(&tx, raw.data(), sizeof(Transaction));
+        char txHash[128] = {0};
+        getTxHashFromDigest(checks[i].digest, txHash);
+        printReceipt(tx, txHash, tx.inputSize ? raw.data() + sizeof(Transaction) : nullptr);
+        if (checks[i].signatureValid)
         {
             LOG("Transaction is VERIFIED\n");
         } else {
             LOG("Transaction is NOT VERIFIED. Incorrect signature\n");
         }
     }
+    if (audit.missing) LOG("%d of %d transactions announced by the tick data are missing\n", audit.missing, audit.numTx);
 }
 
 bool checkTxOnFile(const char* txHash, const char* fileName)
 {
-    TickData td;
-    std::vector<Transaction> txs;
-    std::vector<extraDataStruct> extraData;
-    std::vector<SignatureStruct> signatures;
-    std::vector<TxhashStruct> txHashes;
-
-    readTickDataFromFile(fileName, td, txs, &extraData, &signatures, &txHashes);
-
-    for (int i = 0; i < txs.size(); i++)
+    if (isTickArchive(fileName))
+    {
+        return checkTxOnArchives(txHash, std::vector<std::string>(1, fileName));
+    }
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    uint8_t txDigest[32];
+    if (readTickFile(fileName, *fetched) && getDigestFromTxHash(txHash, txDigest))
     {
-        if (memcmp(txHashes[i].hash, txHash, 60) == 0){
+        uint8_t digest[32];
+        for (auto& raw : fetched->transactions)
+        {
+            KangarooTwelve(raw.data(), (unsigned int)raw.size(), digest, 32);
+            if (memcmp(digest, txDigest, 32) != 0) continue;
+            Transaction tx;
+            memcpy(&tx, raw.data(), sizeof(Transaction));
             LOG("Found tx %s on file %s\n", txHash, fileName);
-            printReceipt(txs[i], txHash, extraData[i].vecU8.data());
+            printReceipt(tx, txHash, raw.data() + sizeof(Transaction));
             return true;
         }
     }
@@ -752,9 +609,7 @@ void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed
     uint64_t commandByte = (uint64_t)(command) << 56;
     packet.cmd.everIncreasingNonceAndCommandType = commandByte | curTime;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
@@ -803,9 +658,7 @@ void toogleMainAux(const char* nodeIp, const int nodePort, const char* seed,
     packet.cmd.mainModeFlag = flag;
     memset(packet.cmd.padding, 0, 7);
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
@@ -850,9 +703,7 @@ void setSolutionThreshold(const char* nodeIp, const int nodePort, const char* se
     packet.cmd.epoch = epoch;
     packet.cmd.threshold = threshold;
 
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
@@ -917,9 +768,7 @@ void syncTime(const char* nodeIp, const int nodePort, const char* seed)
     uint8_t subseed[32] = { 0 };
     uint8_t digest[32] = { 0 };
     uint8_t signature[64] = { 0 };
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
 
     LOG("---------------------------------------------------------------------------------\n");
     LOG("This sets the node clock to roughly be in sync with the local clock.\n");
@@ -1021,21 +870,14 @@ void syncTime(const char* nodeIp, const int nodePort, const char* seed)
     }
 }
 
-BroadcastComputors readComputorListFromFile(const char* fileName)
+ComputorListPtr readComputorListFromFile(const char* fileName)
 {
-    BroadcastComputors result;
-    FILE* f = fopen(fileName, "rb");
-    fread(&result, 1, sizeof(BroadcastComputors), f);
-    fclose(f);
-    uint8_t digest[32] = {0};
-    uint8_t arbPubkey[32] = {0};
-    // verify with arb
-    getPublicKeyFromIdentity(ARBITRATOR, arbPubkey);
-    KangarooTwelve(reinterpret_cast<const uint8_t *>(&result),
-                   sizeof(BroadcastComputors) - SIGNATURE_SIZE,
-                   digest,
-                   32);
-    if (verify(arbPubkey, digest, result.computors.signature)){
+    ComputorListPtr result = loadComputorList(fileName);
+    if (!result){
+        LOG("Failed to read comp list\n");
+        return result;
+    }
+    if (result->arbitratorSigned){
         LOG("Computor list is VERIFIED (signed by ARBITRATOR)\n");
     } else {
         LOG("Computor list is NOT verified\n");
@@ -1055,7 +897,7 @@ bool getComputorFromNode(const char* nodeIp, const int nodePort, BroadcastComput
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {BROADCAST_COMPUTORS});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -1108,45 +950,14 @@ void getComputorListToFile(const char* nodeIp, const int nodePort, const char* f
     fclose(f);
 }
 
-std::vector<std::string> _getNodeIpList(const char* nodeIp, const int nodePort)
-{
-    std::vector<std::string> result;
-    auto qc = make_qc(nodeIp, nodePort);
-    struct {
-        RequestResponseHeader header;
-    } packet;
-    packet.header.setSize(sizeof(packet));
-    packet.header.randomizeDejavu();
-    packet.header.setType(REQUEST_CURRENT_TICK_INFO);
-    qc->sendData((uint8_t *) &packet, packet.header.size());
-    std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = buffer.size();
-    int ptr = 0;
-    while (ptr < recvByte)
-    {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == EXCHANGE_PUBLIC_PEERS){
-            auto epp = (ExchangePublicPeers*)(data + ptr + sizeof(RequestResponseHeader));
-            for (int i = 0; i < 4; i++){
-                std::string new_ip = std::to_string(epp->peers[i][0]) + "." + std::to_string(epp->peers[i][1]) + "." + std::to_string(epp->peers[i][2]) + "." + std::to_string(epp->peers[i][3]);
-                result.push_back(new_ip);
-            }
-        }
-        ptr+= header->size();
-    }
-
-    return result;
-}
 void getNodeIpList(const char* nodeIp, const int nodePort)
 {
     LOG("Fetching node ip list from %s\n", nodeIp);
-    std::vector<std::string> result = _getNodeIpList(nodeIp, nodePort);
-    int count = 0;
-    for (int i = 0; i < result.size() && count++ < 4; i++){
-        std::vector<std::string> new_result = _getNodeIpList(result[i].c_str(), nodePort);
-        result.insert(result.end(), new_result.begin(), new_result.end());
+    // the seed and the first 4 peers it announces are probed concurrently
+    std::vector<std::string> result;
+    for (auto& node : crawlPeers(nodeIp, nodePort, 1, 4))
+    {
+        result.insert(result.end(), node.peers.begin(), node.peers.end());
     }
     std::sort(result.begin(), result.end());
     auto last = std::unique(result.begin(), result.end());
@@ -1169,7 +980,7 @@ void getLogFromNode(const char* nodeIp, const int nodePort, uint64_t* passcode)
     auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondLog::type(), END_RESPONSE});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -1341,9 +1152,7 @@ void sendSpecialCommandGetMiningScoreRanking(const char* nodeIp, const int nodeP
     uint64_t curTime = time(NULL);
     uint64_t commandByte = (uint64_t)(SPECIAL_COMMAND_GET_MINING_SCORE_RANKING) << 56;
     packet.cmd.everIncreasingNonceAndCommandType = commandByte | curTime;
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     KangarooTwelve((unsigned char*)&packet.cmd,
                    sizeof(packet.cmd),
                    digest,
@@ -1356,7 +1165,7 @@ void sendSpecialCommandGetMiningScoreRanking(const char* nodeIp, const int nodeP
     SpecialCommandGetMiningScoreRanking response;
 
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {PROCESS_SPECIAL_COMMAND});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
 
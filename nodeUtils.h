@@ -1,12 +1,58 @@
 #pragma once
+#include <cstdio>
+#include <vector>
+#include "computorCache.h"
 #include "connection.h"
+#include "sparseTickData.h"
 void printTickInfoFromNode(const char* nodeIp, int nodePort);
+void printTickInfo(const CurrentTickInfo& curTickInfo);
+CurrentTickInfo getTickInfoFromNode(QCPtr qc);
+// false if the node has no tick data for this tick (result is zeroed)
+bool getTickDataFromNode(QCPtr qc, const uint32_t tick, TickData& result);
 void printSystemInfoFromNode(const char* nodeIp, int nodePort);
 uint32_t getTickNumberFromNode(QCPtr qc);
 bool checkTxOnTick(const char* nodeIp, const int nodePort, const char* txHash, uint32_t requestedTick);
-void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName);
+bool checkTxOnTick(QCPtr qc, const char* txHash, uint32_t requestedTick);
 void getTickDataToFile(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* fileName);
-void printTickDataFromFile(const char* fileName, const char* compFile);
+// Fetches the transactions of td from the node and writes both in the -gettickdata file format
+void writeTickDataToFile(QCPtr qc, const TickData& td, const char* fileName);
+
+enum TickFetchResult
+{
+    TICK_FETCHED,     // tick data and its transactions were received
+    TICK_EMPTY,       // the node has no tick data for this tick
+    TICK_NOT_REACHED, // the node's current tick is before this tick, ask again later
+};
+
+struct FetchedTick
+{
+    SparseTickData tickData;
+    std::vector<std::vector<uint8_t>> transactions; // each one raw: Transaction, input, signature
+};
+
+// Fetches tick data and transactions of tick, currentTick being the node's current tick
+TickFetchResult fetchTickFromNode(QCPtr qc, uint32_t tick, uint32_t currentTick, FetchedTick& result);
+// Appends tick in the -gettickdata file format (tick data followed by its raw transactions)
+void writeFetchedTick(FILE* f, const FetchedTick& tick);
+
+enum TickVerifyResult
+{
+    TICK_VERIFIED,                // signed by its computor, every announced transaction and nothing else was received
+    TICK_BAD_SIGNATURE,           // the tick data is not signed by the computor of its index
+    TICK_MISSING_TRANSACTIONS,    // some transaction digests have no matching transaction
+    TICK_UNEXPECTED_TRANSACTIONS, // a transaction is not announced by the tick data, or was received twice
+};
+
+// True if td is signed by the computor of its index
+bool verifyTickSignature(const SparseTickData& td, const ComputorList& computors);
+TickVerifyResult verifyFetchedTick(const FetchedTick& tick, const ComputorList& computors);
+bool getComputorFromNode(const char* nodeIp, const int nodePort, BroadcastComputors& result);
+// loadComputorList, telling whether the list is signed by the arbitrator. nullptr if the file can not be read
+ComputorListPtr readComputorListFromFile(const char* fileName);
+// Reads a file in the -gettickdata file format, false if it is too short to hold tick data
+bool readTickFile(const char* fileName, FetchedTick& result);
+// Prints tick data and transactions of a -gettickdata file, the transactions are verified with jobs threads
+void printTickDataFromFile(const char* fileName, const char* compFile, int jobs);
 bool checkTxOnFile(const char* txHash, const char* fileName);
 void sendRawPacket(const char* nodeIp, const int nodePort, int rawPacketSize, uint8_t* rawPacket);
 void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed, int command);
@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "quorumUtils.h"
+#include "connection.h"
+#include "K12AndKeyUtil.h"
+#include "keyUtils.h"
+#include "logger.h"
+#include "nodeUtils.h"
+#include "utils.h"
+
+namespace
+{
+    // Runs work(begin, end) over [0, count) in chunks of VOTE_CHECK_CHUNK_SIZE with jobs threads
+    template <typename Work>
+    void forEachChunk(size_t count, int jobs, Work work)
+    {
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for (size_t begin = next.fetch_add(VOTE_CHECK_CHUNK_SIZE); begin < count; begin = next.fetch_add(VOTE_CHECK_CHUNK_SIZE))
+            {
+                work(begin, std::min(begin + VOTE_CHECK_CHUNK_SIZE, count));
+            }
+        };
+        size_t threads = std::min(size_t(std::max(jobs, 1)), (count + VOTE_CHECK_CHUNK_SIZE - 1) / VOTE_CHECK_CHUNK_SIZE);
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; t++) workers.emplace_back(worker);
+        worker();
+        for (auto& thread : workers) thread.join();
+    }
+
+    VoteSaltCheck checkVoteSalt(const Tick& vote, const uint8_t* publicKey, const Tick& nextVote)
+    {
+        uint8_t saltedData[64];
+        uint8_t saltedDigest[32];
+        memset(saltedData, 0, 64);
+        memcpy(saltedData, publicKey, 32);
+        memcpy(saltedData + 32, &nextVote.prevResourceTestingDigest, 8);
+        KangarooTwelve(saltedData, 40, saltedDigest, 8);
+        if (vote.saltedResourceTestingDigest != *((unsigned long long*)(saltedDigest))) return VOTE_SALT_BAD_RESOURCE_TESTING;
+        memcpy(saltedData + 32, nextVote.prevSpectrumDigest, 32);
+        KangarooTwelve(saltedData, 64, saltedDigest, 32);
+        if (memcmp(saltedDigest, vote.saltedSpectrumDigest, 32) != 0) return VOTE_SALT_BAD_SPECTRUM;
+        memcpy(saltedData + 32, nextVote.prevUniverseDigest, 32);
+        KangarooTwelve(saltedData, 64, saltedDigest, 32);
+        if (memcmp(saltedDigest, vote.saltedUniverseDigest, 32) != 0) return VOTE_SALT_BAD_UNIVERSE;
+        memcpy(saltedData + 32, nextVote.prevComputerDigest, 32);
+        KangarooTwelve(saltedData, 64, saltedDigest, 32);
+        if (memcmp(saltedDigest, vote.saltedComputerDigest, 32) != 0) return VOTE_SALT_BAD_COMPUTER;
+        return VOTE_SALT_VALID;
+    }
+
+    const char* saltDigestName(VoteSaltCheck check)
+    {
+        switch (check)
+        {
+            case VOTE_SALT_BAD_RESOURCE_TESTING: return "saltedResourceTestingDigest";
+            case VOTE_SALT_BAD_SPECTRUM: return "saltedSpectrumDigest";
+            case VOTE_SALT_BAD_UNIVERSE: return "saltedUniverseDigest";
+            case VOTE_SALT_BAD_COMPUTER: return "saltedComputerDigest";
+            default: return "";
+        }
+    }
+
+    void dumpQuorumTick(const Tick& A, bool dumpComputorIndex = true)
+    {
+        char digest[64] = {0};
+        if (dumpComputorIndex) LOG("Computor index: %d\n", A.computorIndex);
+        LOG("Epoch: %d\n", A.epoch);
+        LOG("Tick: %d\n", A.tick);
+        LOG("Time: 20%02u-%02u-%02u %02u:%02u:%02u.%04u\n", A.year, A.month, A.day, A.hour, A.minute, A.second, A.millisecond);
+        LOG("prevResourceTestingDigest: %llu\n", A.prevResourceTestingDigest);
+        getIdentityFromPublicKey(A.prevSpectrumDigest, digest, true);
+        LOG("prevSpectrumDigest: %s\n", digest);
+        getIdentityFromPublicKey(A.prevUniverseDigest, digest, true);
+        LOG("prevUniverseDigest: %s\n", digest);
+        getIdentityFromPublicKey(A.prevComputerDigest, digest, true);
+        LOG("prevComputerDigest: %s\n", digest);
+        getIdentityFromPublicKey(A.transactionDigest, digest, true);
+        LOG("transactionDigest: %s\n", digest);
+        getIdentityFromPublicKey(A.expectedNextTickTransactionDigest, digest, true);
+        LOG("expectedNextTickTransactionDigest: %s\n", digest);
+    }
+
+    std::string indexToAlphabet(int index)
+    {
+        std::string result = "";
+        result += char('A' + (index/26));
+        result += char('A' + (index%26));
+        return result;
+    }
+
+    std::vector<Tick> requestVotes(QCPtr qc, uint32_t tick)
+    {
+        struct
+        {
+            RequestResponseHeader header;
+            RequestedQuorumTick rqt;
+        } packet;
+        packet.header.setSize(sizeof(packet));
+        packet.header.randomizeDejavu();
+        packet.header.setType(RequestedQuorumTick::type);
+        packet.rqt.tick = tick;
+        memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
+        qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
+        return qc->getLatestVectorPacketAs<Tick>();
+    }
+
+    // Index of the unique vote most computors voted, the first one on a tie
+    int majorityOf(const std::vector<std::vector<int>>& voteIndices)
+    {
+        int result = 0;
+        for (int i = 1; i < int(voteIndices.size()); i++)
+        {
+            if (voteIndices[result].size() < voteIndices[i].size()) result = i;
+        }
+        return result;
+    }
+
+    // Votes of one tick fetched by -quorumrange
+    struct TickVotes
+    {
+        bool answered;
+        std::vector<Tick> votes;       // as received
+        std::vector<Tick> signedVotes; // the votes signed by the computor of their index
+        bool hasQuorum;                // at least QUORUM_VOTES signed votes, majorityVote is the most common of them
+        Tick majorityVote;
+    };
+
+    struct ComputorHealth
+    {
+        int noVote;       // ticks the node had votes for but none of this computor
+        int badSignature;
+        int badSalt;
+        int misaligned;
+    };
+
+    // Fetches the votes of ticks fromTick to toTick with one pipelined request per tick and checks their signatures
+    // with jobs threads. One TickVotes per tick is appended to result. False if the connection was lost
+    bool fetchVoteRange(QCPtr qc, uint32_t fromTick, uint32_t toTick, const ComputorList& computors, int jobs,
+                        std::vector<TickVotes>& result)
+    {
+        struct
+        {
+            RequestResponseHeader header;
+            RequestedQuorumTick rqt;
+        } packet;
+        packet.header.setSize(sizeof(packet));
+        packet.header.setType(RequestedQuorumTick::type);
+        memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
+        std::vector<PipelineRequest> requests(toTick - fromTick + 1);
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            packet.rqt.tick = fromTick + uint32_t(i);
+            requests[i].packet.assign((uint8_t*)&packet, (uint8_t*)&packet + sizeof(packet));
+            requests[i].responseType = Tick::type();
+            requests[i].multiPacket = true;
+        }
+        qc->pipeline(requests, QUORUM_RANGE_IN_FLIGHT);
+
+        size_t first = result.size();
+        bool complete = true;
+        std::vector<Tick> all;
+        for (auto& request : requests)
+        {
+            TickVotes tick;
+            tick.answered = request.completed;
+            tick.hasQuorum = false;
+            complete = complete && request.completed;
+            if (request.completed)
+            {
+                tick.votes.resize(request.response.size() / sizeof(Tick));
+                if (!tick.votes.empty()) memcpy(tick.votes.data(), request.response.data(), tick.votes.size() * sizeof(Tick));
+                all.insert(all.end(), tick.votes.begin(), tick.votes.end());
+            }
+            result.push_back(tick);
+        }
+        std::vector<uint8_t> valid;
+        verifyVoteSignatures(all, computors, jobs, valid);
+
+        size_t offset = 0;
+        for (size_t t = first; t < result.size(); t++)
+        {
+            TickVotes& tick = result[t];
+            for (auto& vote : tick.votes)
+            {
+                if (valid[offset++]) tick.signedVotes.push_back(vote);
+            }
+            if (tick.signedVotes.size() >= QUORUM_VOTES)
+            {
+                std::vector<Tick> uniqueVote;
+                std::vector<std::vector<int>> voteIndices;
+                getUniqueVotes(tick.signedVotes, uniqueVote, voteIndices);
+                tick.hasQuorum = true;
+                tick.majorityVote = uniqueVote[majorityOf(voteIndices)];
+            }
+        }
+        if (complete) return true;
+        // answers to the requests left behind may still come, start over on a clean session
+        try
+        {
+            qc->reconnect();
+        }
+        catch (std::logic_error&)
+        {
+            return false;
+        }
+        return true;
+    }
+
+    // Salt check of tick against next, grouping and majority of the votes that pass
+    void summarizeTick(uint32_t tickNumber, const TickVotes& tick, const TickVotes& next, const ComputorList& computors,
+                       int jobs, QuorumTickSummary& summary, std::vector<ComputorHealth>& health)
+    {
+        memset(&summary, 0, sizeof(summary));
+        summary.tick = tickNumber;
+        summary.votes = tick.answered ? int16_t(tick.votes.size()) : -1;
+        summary.badSignatures = int16_t(tick.votes.size() - tick.signedVotes.size());
+        summary.saltFailures = -1;
+        std::vector<uint8_t> voted(NUMBER_OF_COMPUTORS, 0), signedBy(NUMBER_OF_COMPUTORS, 0);
+        for (auto& vote : tick.votes) if (vote.computorIndex < NUMBER_OF_COMPUTORS) voted[vote.computorIndex] = 1;
+        for (auto& vote : tick.signedVotes) signedBy[vote.computorIndex] = 1;
+        for (int i = 0; i < NUMBER_OF_COMPUTORS && !tick.votes.empty(); i++)
+        {
+            if (!voted[i]) health[i].noVote++;
+            else if (!signedBy[i]) health[i].badSignature++;
+        }
+        std::vector<Tick> checkedVotes;
+        if (next.hasQuorum)
+        {
+            std::vector<VoteSaltCheck> salts;
+            checkVoteSalts(tick.signedVotes, computors, next.majorityVote, jobs, salts);
+            summary.saltFailures = 0;
+            for (size_t i = 0; i < tick.signedVotes.size(); i++)
+            {
+                if (salts[i] == VOTE_SALT_VALID)
+                {
+                    checkedVotes.push_back(tick.signedVotes[i]);
+                    continue;
+                }
+                summary.saltFailures++;
+                health[tick.signedVotes[i].computorIndex].badSalt++;
+            }
+        }
+        else
+        {
+            checkedVotes = tick.signedVotes;
+        }
+        if (checkedVotes.empty()) return;
+
+        std::vector<Tick> uniqueVote;
+        std::vector<std::vector<int>> voteIndices;
+        std::vector<VoteKey> keys;
+        getUniqueVotes(checkedVotes, uniqueVote, voteIndices, &keys);
+        int majority = majorityOf(voteIndices);
+        summary.uniqueVotes = int16_t(uniqueVote.size());
+        summary.majority = int16_t(voteIndices[majority].size());
+        summary.misaligned = int16_t(checkedVotes.size() - voteIndices[majority].size());
+        memcpy(summary.majorityKey, keys[majority].digest, 32);
+        for (int i = 0; i < int(voteIndices.size()); i++)
+        {
+            if (i == majority) continue;
+            for (int index : voteIndices[i]) health[index].misaligned++;
+        }
+    }
+
+    std::string quorumSummaryCsv(const QuorumTickSummary& summary)
+    {
+        char key[65] = {0};
+        byteToHex(summary.majorityKey, key, 32);
+        return std::to_string(summary.tick) + "," + std::to_string(summary.votes) + "," + std::to_string(summary.badSignatures)
+               + "," + std::to_string(summary.saltFailures) + "," + std::to_string(summary.uniqueVotes)
+               + "," + std::to_string(summary.majority) + "," + std::to_string(summary.misaligned)
+               + "," + (summary.majority ? key : "") + "\n";
+    }
+}
+
+void verifyVoteSignatures(const std::vector<Tick>& votes, const ComputorList& computors, int jobs, std::vector<uint8_t>& valid)
+{
+    valid.assign(votes.size(), 0);
+    forEachChunk(votes.size(), jobs, [&](size_t begin, size_t end)
+    {
+        uint8_t digest[32];
+        Tick vote;
+        for (size_t i = begin; i < end; i++)
+        {
+            if (votes[i].computorIndex >= NUMBER_OF_COMPUTORS) continue;
+            vote = votes[i];
+            vote.computorIndex ^= Tick::type();
+            KangarooTwelve((uint8_t*)&vote, sizeof(Tick) - SIGNATURE_SIZE, digest, 32);
+            valid[i] = verifyComputorSignature(computors, votes[i].computorIndex, digest, votes[i].signature);
+        }
+    });
+}
+
+void checkVoteSalts(const std::vector<Tick>& votes, const ComputorList& computors, const Tick& nextVote, int jobs,
+                    std::vector<VoteSaltCheck>& results)
+{
+    results.assign(votes.size(), VOTE_SALT_VALID);
+    forEachChunk(votes.size(), jobs, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            if (votes[i].computorIndex >= NUMBER_OF_COMPUTORS) continue;
+            results[i] = checkVoteSalt(votes[i], computors.publicKey(votes[i].computorIndex), nextVote);
+        }
+    });
+}
+
+VoteKey getVoteKey(const Tick& vote)
+{
+    uint8_t fields[2 + 4 + 2 + 6 + 8 + 5 * 32];
+    uint8_t* ptr = fields;
+    memcpy(ptr, &vote.epoch, 2); ptr += 2;
+    memcpy(ptr, &vote.tick, 4); ptr += 4;
+    memcpy(ptr, &vote.millisecond, 2); ptr += 2;
+    *ptr++ = vote.second;
+    *ptr++ = vote.minute;
+    *ptr++ = vote.hour;
+    *ptr++ = vote.day;
+    *ptr++ = vote.month;
+    *ptr++ = vote.year;
+    memcpy(ptr, &vote.prevResourceTestingDigest, 8); ptr += 8;
+    memcpy(ptr, vote.prevSpectrumDigest, 32); ptr += 32;
+    memcpy(ptr, vote.prevUniverseDigest, 32); ptr += 32;
+    memcpy(ptr, vote.prevComputerDigest, 32); ptr += 32;
+    memcpy(ptr, vote.transactionDigest, 32); ptr += 32;
+    memcpy(ptr, vote.expectedNextTickTransactionDigest, 32);
+    VoteKey key;
+    KangarooTwelve(fields, sizeof(fields), key.digest, 32);
+    return key;
+}
+
+void getUniqueVotes(const std::vector<Tick>& votes, std::vector<Tick>& uniqueVote, std::vector<std::vector<int>>& voteIndices,
+                    std::vector<VoteKey>* uniqueKeys)
+{
+    uniqueVote.resize(0);
+    voteIndices.resize(0);
+    if (uniqueKeys) uniqueKeys->resize(0);
+    std::unordered_map<VoteKey, int, VoteKeyHash> groups;
+    for (auto& vote : votes)
+    {
+        VoteKey key = getVoteKey(vote);
+        auto it = groups.find(key);
+        if (it != groups.end())
+        {
+            voteIndices[it->second].push_back(vote.computorIndex);
+            continue;
+        }
+        groups[key] = int(uniqueVote.size());
+        uniqueVote.push_back(vote);
+        voteIndices.push_back(std::vector<int>(1, vote.computorIndex));
+        if (uniqueKeys) uniqueKeys->push_back(key);
+    }
+}
+
+void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName, int jobs)
+{
+    auto qc = make_qc(nodeIp, nodePort);
+    ComputorListPtr computors = loadComputorList(compFileName);
+    if (!computors){
+        LOG("Failed to read comp list\n");
+        return;
+    }
+
+    auto votes = requestVotes(qc, requestedTick);
+    LOG("Received %d quorum tick #%u (votes)\n", votes.size(), requestedTick);
+    auto votes_next = requestVotes(qc, requestedTick + 1);
+    LOG("Received %d quorum tick #%u (votes)\n", votes_next.size(), requestedTick+1);
+
+    int N = votes.size();
+    if (N == 0){
+        return;
+    }
+
+    // both ticks' signatures in one pass, failures are then reported in vote order
+    std::vector<Tick> all(votes);
+    all.insert(all.end(), votes_next.begin(), votes_next.end());
+    std::vector<uint8_t> valid;
+    verifyVoteSignatures(all, *computors, jobs, valid);
+    std::vector<Tick> signedVotes, signedVotesNext;
+    std::vector<int> signedIndices; // position of signedVotes[i] in votes
+    for (int i = 0; i < N; i++){
+        if (valid[i]){
+            signedVotes.push_back(votes[i]);
+            signedIndices.push_back(i);
+        } else {
+            LOG("Signature of vote %d is not correct\n", i);
+            dumpQuorumTick(votes[i]);
+        }
+    }
+    if (signedVotes.size() < votes.size()){
+        LOG("%d of %d votes have an incorrect signature and are left out\n", int(votes.size() - signedVotes.size()), N);
+    }
+    for (size_t i = 0; i < votes_next.size(); i++){
+        if (valid[N + i]) signedVotesNext.push_back(votes_next[i]);
+    }
+    if (signedVotesNext.size() < votes_next.size()){
+        LOG("%d of %d votes of tick %u have an incorrect signature and are left out\n",
+            int(votes_next.size() - signedVotesNext.size()), int(votes_next.size()), requestedTick+1);
+    }
+
+    std::vector<Tick> uniqueVote, uniqueVoteNext;
+    std::vector<std::vector<int>> voteIndices, voteIndicesNext;
+    std::vector<Tick> checkedVotes;
+    if (signedVotesNext.size() < QUORUM_VOTES)
+    {
+        LOG("Failed to get votes for tick %d, this will not perform salt check\n", requestedTick+1);
+        checkedVotes = signedVotes;
+    }
+    else
+    {
+        // the next tick's majority tells the state digests this tick's votes were salted with
+        getUniqueVotes(signedVotesNext, uniqueVoteNext, voteIndicesNext);
+        int max_id = majorityOf(voteIndicesNext);
+        LOG("Performing salt check...\n");
+        std::vector<VoteSaltCheck> salts;
+        checkVoteSalts(signedVotes, *computors, uniqueVoteNext[max_id], jobs, salts);
+        for (int i = 0; i < signedVotes.size(); i++){
+            if (salts[i] == VOTE_SALT_VALID){
+                checkedVotes.push_back(signedVotes[i]);
+                continue;
+            }
+            LOG("Mismatched %s. Computor index: %d\n", saltDigestName(salts[i]), signedVotes[i].computorIndex);
+            LOG("Vote %d failed to pass salt check\n", signedIndices[i]);
+            dumpQuorumTick(signedVotes[i]);
+        }
+        if (checkedVotes.size() == signedVotes.size()){
+            LOG("ALL votes PASSED salts check\n");
+        } else {
+            LOG("%d of %d votes failed the salt check and are left out\n", int(signedVotes.size() - checkedVotes.size()), int(signedVotes.size()));
+        }
+    }
+    getUniqueVotes(checkedVotes, uniqueVote, voteIndices);
+
+    LOG("Number of unique votes: %d\n", uniqueVote.size());
+    for (int i = 0; i < uniqueVote.size(); i++){
+        LOG("Vote #%d (voted by %d computors ID) ", i, voteIndices[i].size());
+        const bool dumpComputorIndex = false;
+        dumpQuorumTick(uniqueVote[i], dumpComputorIndex);
+        LOG("Voted by: ");
+        std::sort(voteIndices[i].begin(), voteIndices[i].end());
+        for (int j = 0; j < voteIndices[i].size(); j++){
+            int index = voteIndices[i][j];
+            auto alphabet = indexToAlphabet(index);
+            if (j < voteIndices[i].size() - 1){
+                LOG("%d(%s), ", index, alphabet.c_str());
+            } else {
+                LOG("%d(%s)\n", index, alphabet.c_str());
+            }
+        }
+    }
+}
+
+EmptyTickQuorum checkEmptyTickQuorum(QCPtr qc, uint32_t tick, const ComputorList& computors)
+{
+    std::vector<Tick> votes = requestVotes(qc, tick);
+    std::vector<uint8_t> valid;
+    verifyVoteSignatures(votes, computors, 1, valid);
+    uint8_t zero[32] = {0};
+    std::vector<uint8_t> counted(NUMBER_OF_COMPUTORS, 0);
+    int empty = 0, withData = 0;
+    for (size_t i = 0; i < votes.size(); i++)
+    {
+        const Tick& vote = votes[i];
+        if (!valid[i] || vote.computorIndex >= NUMBER_OF_COMPUTORS || vote.tick != tick || vote.epoch != computors.epoch() || counted[vote.computorIndex]) continue;
+        counted[vote.computorIndex] = 1;
+        // computors vote a zero transaction digest for a tick without tick data
+        if (memcmp(vote.transactionDigest, zero, 32) == 0) empty++;
+        else withData++;
+    }
+    if (empty >= QUORUM_VOTES) return EMPTY_TICK_CONFIRMED;
+    if (withData >= QUORUM_VOTES) return EMPTY_TICK_HAS_DATA;
+    return EMPTY_TICK_NO_QUORUM;
+}
+
+void getQuorumRange(const char* nodeIp, const int nodePort, const char* compFileName, uint32_t fromTick, uint32_t toTick,
+                    const char* output, int jobs)
+{
+    // the command line checks this too, other callers would otherwise get a misleading "lost the connection"
+    if (fromTick == 0 || fromTick > toTick || toTick == UINT32_MAX)
+    {
+        LOG("Invalid tick range %u to %u\n", fromTick, toTick);
+        return;
+    }
+    ComputorListPtr computors = readComputorListFromFile(compFileName);
+    if (!computors) return;
+    std::string name = output;
+    bool toScreen = name == "-";
+    bool csv = toScreen || (name.size() > 4 && name.compare(name.size() - 4, 4, ".csv") == 0);
+    FILE* f = nullptr;
+    if (!toScreen)
+    {
+        f = fopen(output, csv ? "w" : "wb");
+        if (f == nullptr)
+        {
+            LOG("Failed to open %s\n", output);
+            return;
+        }
+    }
+    const char* header = "Tick,Votes,BadSignatures,SaltFailures,UniqueVotes,Majority,Misaligned,MajorityKey\n";
+    if (toScreen) LOG("%s", header);
+    else if (csv) fwrite(header, 1, strlen(header), f);
+
+    auto qc = make_qc(nodeIp, nodePort);
+    std::vector<ComputorHealth> health(NUMBER_OF_COMPUTORS);
+    memset(health.data(), 0, health.size() * sizeof(ComputorHealth));
+    int checked = 0, notAnswered = 0, noQuorum = 0, saltUnchecked = 0;
+    uint32_t lastTick = fromTick - 1;
+    std::vector<TickVotes> ticks;
+    // ticks of a batch need the votes of the tick after the batch for their salts, those are kept for the next batch
+    for (uint32_t batchFrom = fromTick; batchFrom <= toTick; batchFrom += QUORUM_RANGE_BATCH)
+    {
+        uint32_t batchTo = std::min(toTick, batchFrom + QUORUM_RANGE_BATCH - 1);
+        if (ticks.empty())
+        {
+            if (!fetchVoteRange(qc, batchFrom, batchTo + 1, *computors, jobs, ticks)) break;
+        }
+        else
+        {
+            ticks.erase(ticks.begin(), ticks.end() - 1);
+            if (!fetchVoteRange(qc, batchFrom + 1, batchTo + 1, *computors, jobs, ticks)) break;
+        }
+        for (uint32_t tick = batchFrom; tick <= batchTo; tick++)
+        {
+            QuorumTickSummary summary;
+            summarizeTick(tick, ticks[tick - batchFrom], ticks[tick - batchFrom + 1], *computors, jobs, summary, health);
+            checked++;
+            if (summary.votes < 0) notAnswered++;
+            if (summary.majority < QUORUM_VOTES) noQuorum++;
+            if (summary.saltFailures < 0) saltUnchecked++;
+            if (toScreen) LOG("%s", quorumSummaryCsv(summary).c_str());
+            else if (csv) fputs(quorumSummaryCsv(summary).c_str(), f);
+            else fwrite(&summary, 1, sizeof(summary), f);
+            lastTick = tick;
+        }
+        if (batchTo == toTick) break;
+    }
+    if (f) fclose(f);
+
+    if (checked == 0)
+    {
+        LOG("Lost the connection to %s:%d before tick %u\n", nodeIp, nodePort, fromTick);
+        return;
+    }
+    if (lastTick < toTick) LOG("Lost the connection to %s:%d after tick %u\n", nodeIp, nodePort, lastTick);
+    LOG("Checked %d ticks from %u to %u: %d without answer, %d without a majority of %d votes, %d without salt check\n",
+        checked, fromTick, lastTick, notAnswered, noQuorum, QUORUM_VOTES, saltUnchecked);
+    for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+    {
+        const ComputorHealth& h = health[i];
+        if (!h.noVote && !h.badSignature && !h.badSalt && !h.misaligned) continue;
+        LOG("Computor %d(%s): no vote %d, bad signature %d, bad salt %d, not with the majority %d\n",
+            i, indexToAlphabet(i).c_str(), h.noVote, h.badSignature, h.badSalt, h.misaligned);
+    }
+}
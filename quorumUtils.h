@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "computorCache.h"
+#include "connection.h"
+#include "structs.h"
+
+#define QUORUM_VOTES 451       // votes a tick needs to be final (2/3 of the computors + 1)
+#define VOTE_CHECK_CHUNK_SIZE 16 // votes a checking thread takes at once
+#define QUORUM_RANGE_BATCH 64    // ticks -quorumrange fetches and checks at a time
+#define QUORUM_RANGE_IN_FLIGHT 4 // vote requests -quorumrange keeps outstanding, each is answered by up to 676 votes
+
+enum VoteSaltCheck
+{
+    VOTE_SALT_VALID,
+    VOTE_SALT_BAD_RESOURCE_TESTING,
+    VOTE_SALT_BAD_SPECTRUM,
+    VOTE_SALT_BAD_UNIVERSE,
+    VOTE_SALT_BAD_COMPUTER,
+};
+
+// K12 digest of the fields computors have to agree on, everything but computor index, salted digests and signature.
+// Votes with the same content have the same key, whichever computor, node or run they come from
+struct VoteKey
+{
+    uint8_t digest[32];
+    bool operator==(const VoteKey& other) const { return memcmp(digest, other.digest, 32) == 0; }
+    bool operator!=(const VoteKey& other) const { return !(*this == other); }
+};
+
+struct VoteKeyHash
+{
+    size_t operator()(const VoteKey& key) const
+    {
+        uint64_t value;
+        memcpy(&value, key.digest, sizeof(value));
+        return size_t(value);
+    }
+};
+
+VoteKey getVoteKey(const Tick& vote);
+
+// Checks the signature of every vote against the computor of its index with jobs threads, valid[i] belongs to votes[i]
+void verifyVoteSignatures(const std::vector<Tick>& votes, const ComputorList& computors, int jobs, std::vector<uint8_t>& valid);
+// Checks the salted digests of every vote against the state digests the votes of the next tick start from (nextVote),
+// with jobs threads. results[i] belongs to votes[i]
+void checkVoteSalts(const std::vector<Tick>& votes, const ComputorList& computors, const Tick& nextVote, int jobs,
+                    std::vector<VoteSaltCheck>& results);
+// Groups votes by their key in order of first appearance, voteIndices[i] being the computors that voted uniqueVote[i]
+// and (*uniqueKeys)[i] its key
+void getUniqueVotes(const std::vector<Tick>& votes, std::vector<Tick>& uniqueVote, std::vector<std::vector<int>>& voteIndices,
+                    std::vector<VoteKey>* uniqueKeys = nullptr);
+
+enum EmptyTickQuorum
+{
+    EMPTY_TICK_CONFIRMED, // QUORUM_VOTES signed votes with a zero transaction digest: the tick has no tick data for good
+    EMPTY_TICK_HAS_DATA,  // QUORUM_VOTES signed votes with a transaction digest: the tick data exists
+    EMPTY_TICK_NO_QUORUM, // neither, the votes are not all there yet
+};
+// Asks the node for the votes of tick and tells whether computors agreed on it having no tick data
+EmptyTickQuorum checkEmptyTickQuorum(QCPtr qc, uint32_t tick, const ComputorList& computors);
+
+// Prints the votes of requestedTick, grouped by content, after checking their signatures and their salts
+// (when the next tick has a quorum) with jobs threads. Every failing vote is reported
+void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName, int jobs);
+
+// Record of -quorumrange binary output, one per tick in tick order
+struct QuorumTickSummary
+{
+    uint32_t tick;
+    int16_t votes;         // votes received, -1 if the node did not answer
+    int16_t badSignatures; // votes not signed by the computor of their index
+    int16_t saltFailures;  // signed votes with a wrong salted digest, -1 if tick + 1 has no quorum to check them against
+    int16_t uniqueVotes;   // distinct votes among the signed votes that passed the salt check
+    int16_t majority;      // votes agreeing with the most common one
+    int16_t misaligned;    // signed votes that passed the salt check but differ from the most common one
+    uint8_t majorityKey[32]; // VoteKey of the most common vote, zeroed if there is none
+};
+static_assert(sizeof(QuorumTickSummary) == 48, "QuorumTickSummary is a file format");
+
+// Checks the votes of every tick from fromTick to toTick like getQuorumTick, fetching them with pipelined requests
+// and reading the computor list once. A summary per tick is written to output: CSV to the screen for "-", CSV for
+// a name ending in .csv, QuorumTickSummary records otherwise. The computors that failed are listed at the end
+void getQuorumRange(const char* nodeIp, const int nodePort, const char* compFileName, uint32_t fromTick, uint32_t toTick,
+                    const char* output, int jobs);
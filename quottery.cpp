@@ -42,7 +42,7 @@ void quotteryGetBasicInfo(const char* nodeIp, const int nodePort, qtryBasicInfo_
     packet.rcf.contractIndex = QUOTTERY_CONTRACT_ID;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -130,9 +130,7 @@ void quotteryIssueBet(const char* nodeIp, int nodePort, const char* seed, uint32
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
@@ -256,9 +254,7 @@ void quotteryJoinBet(const char* nodeIp, int nodePort, const char* seed, uint32_
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
@@ -319,7 +315,7 @@ void quotteryGetBetInfo(const char* nodeIp, const int nodePort, int betId, getBe
     packet.input.betId = betId;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -400,7 +396,8 @@ void quotteryPrintBetInfo(const char* nodeIp, const int nodePort, int betId){
 }
 
 //  getBetOptionDetail 3
-void quotteryGetBetOptionDetail(const char* nodeIp, const int nodePort, uint32_t betId, uint32_t betOption, getBetOptionDetail_output& result){
+// The result is read in place from buffer, nullptr if the node did not answer
+const getBetOptionDetail_output* quotteryGetBetOptionDetail(const char* nodeIp, const int nodePort, uint32_t betId, uint32_t betOption, ReceiveBuffer& buffer){
     auto qc = make_qc(nodeIp, nodePort);
     struct {
         RequestResponseHeader header;
@@ -416,37 +413,30 @@ void quotteryGetBetOptionDetail(const char* nodeIp, const int nodePort, uint32_t
     packet.bo_inp.betId = betId;
     packet.bo_inp.betOption = betOption;
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = buffer.size();
-    int ptr = 0;
-    while (ptr < recvByte)
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
+    const getBetOptionDetail_output* result = nullptr;
+    for (auto& response : splitPackets(buffer.data(), buffer.size()))
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == RespondContractFunction::type()){
-            auto oup = (getBetOptionDetail_output*)(data + ptr + sizeof(RequestResponseHeader));
-            result = *oup;
+        if (response.type() == RespondContractFunction::type() && response.as<getBetOptionDetail_output>()){
+            result = response.as<getBetOptionDetail_output>();
         }
-        ptr+= header->size();
     }
-
+    return result;
 }
 // showing which ID bet for an option
 void quotteryPrintBetOptionDetail(const char* nodeIp, const int nodePort, uint32_t betId, uint32_t betOption){
-    getBetOptionDetail_output result;
-    memset(&result, 0, sizeof(getBetOptionDetail_output));
-    quotteryGetBetOptionDetail(nodeIp, nodePort, betId, betOption, result);
-    if (isArrayZero((uint8_t*)&result, sizeof(getBetOptionDetail_output))){
+    ReceiveBuffer buffer;
+    auto result = quotteryGetBetOptionDetail(nodeIp, nodePort, betId, betOption, buffer);
+    if (!result || isArrayZero((const uint8_t*)result, sizeof(getBetOptionDetail_output))){
         LOG("Failed to get\n");
         return;
     }
     LOG("List of IDs bet option #%d on betID %d\n", betOption, betId);
     char buf[128] = {0};
     for (int i = 0; i < 1024; i++){
-        if (!isZeroPubkey(result.bettor + i*32)){
+        if (!isZeroPubkey(result->bettor + i*32)){
             memset(buf, 0, 128);
-            getIdentityFromPublicKey(result.bettor + i * 32, buf, false);
+            getIdentityFromPublicKey(result->bettor + i * 32, buf, false);
             LOG("%s\n", buf);
         }
     }
@@ -466,7 +456,7 @@ void quotteryGetActiveBet(const char* nodeIp, const int nodePort, getActiveBet_o
     packet.rcf.contractIndex = QUOTTERY_CONTRACT_ID;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -510,7 +500,7 @@ void quotteryGetActiveBetByCreator(const char* nodeIp, const int nodePort, getAc
     memcpy(packet.abi.creator, creator, 32);
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -549,9 +539,7 @@ void quotteryCancelBet(const char* nodeIp, const int nodePort, const char* seed,
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
@@ -603,9 +591,7 @@ void quotteryPublishResult(const char* nodeIp, const int nodePort, const char* s
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUOTTERY_CONTRACT_ID;
@@ -85,9 +85,7 @@ void qutilSendToManyV1(const char* nodeIp, int nodePort, const char* seed, const
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUTIL_CONTRACT_ID;
@@ -151,9 +149,7 @@ void qutilBurnQubic(const char* nodeIp, int nodePort, const char* seed, long lon
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     ((uint64_t*)destPublicKey)[0] = QUTIL_CONTRACT_ID;
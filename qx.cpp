@@ -6,6 +6,7 @@
 #include "assetUtil.h"
 #include "connection.h"
 #include "logger.h"
+#include "daemon.h"
 #include "nodeUtils.h"
 #include "K12AndKeyUtil.h"
 #include "qx.h"
@@ -32,6 +33,18 @@
 
 void getQxFees(const char* nodeIp, const int nodePort, QxFees_output& result){
     auto qc = make_qc(nodeIp, nodePort);
+    getQxFees(qc, result);
+}
+
+RequestContractFunction getQxFeesRequest(){
+    RequestContractFunction rcf;
+    rcf.inputSize = 0;
+    rcf.inputType = QX_GET_FEE_PR;
+    rcf.contractIndex = QX_CONTRACT_INDEX;
+    return rcf;
+}
+
+void getQxFees(QCPtr qc, QxFees_output& result){
     struct {
         RequestResponseHeader header;
         RequestContractFunction rcf;
@@ -39,12 +52,10 @@ void getQxFees(const char* nodeIp, const int nodePort, QxFees_output& result){
     packet.header.setSize(sizeof(packet));
     packet.header.randomizeDejavu();
     packet.header.setType(RequestContractFunction::type());
-    packet.rcf.inputSize = 0;
-    packet.rcf.inputType = QX_GET_FEE_PR;
-    packet.rcf.contractIndex = QX_CONTRACT_INDEX;
+    packet.rcf = getQxFeesRequest();
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -66,6 +77,10 @@ void getQxFees(const char* nodeIp, const int nodePort, QxFees_output& result){
 void printQxFee(const char* nodeIp, const int nodePort){
     QxFees_output result;
     getQxFees(nodeIp, nodePort, result);
+    printQxFee(result);
+}
+
+void printQxFee(const QxFees_output& result){
     LOG("Asset issuance fee: %u\n", result.assetIssuanceFee);
     LOG("Transfer fee: %u\n", result.transferFee);
     LOG("Trade fee: %u\n", result.tradeFee);
@@ -91,9 +106,7 @@ void qxIssueAsset(const char* nodeIp, int nodePort,
     uint8_t digest[32] = {0};
     uint8_t signature[64] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subSeed, privateKey, sourcePublicKey);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
 
     struct {
@@ -169,13 +182,11 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
     memcpy(assetNameU1, pAssetName, strlen(pAssetName));
     if (strlen(pIssuerInQubicFormat) != 60){
         LOG("WARNING: Stop supporting hex format, please use qubic format 60-char length addresses\n");
-        exit(0);
+        cliExit(0);
     }
     getPublicKeyFromIdentity(pIssuerInQubicFormat, issuer);
 
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subSeed, privateKey, sourcePublicKey);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
     getPublicKeyFromIdentity(newOwnerIdentity, newOwnerPublicKey);
     struct {
@@ -245,13 +256,11 @@ void qxOrderAction(const char* nodeIp, int nodePort,
     memcpy(assetNameU1, pAssetName, strlen(pAssetName));
     if (strlen(pIssuerInQubicFormat) != 60){
         LOG("WARNING: Stop supporting hex format, please use qubic format 60-char length addresses\n");
-        exit(0);
+        cliExit(0);
     }
     getPublicKeyFromIdentity(pIssuerInQubicFormat, issuer);
 
-    getSubseedFromSeed((uint8_t*)seed, subSeed);
-    getPrivateKeyFromSubSeed(subSeed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subSeed, privateKey, sourcePublicKey);
     getPublicKeyFromIdentity(QX_ADDRESS, destPublicKey);
     struct {
         RequestResponseHeader header;
@@ -381,7 +390,7 @@ void qxGetAssetOrder(const char* nodeIp, int nodePort,
     memcpy(assetNameU1, pAssetName, strlen(pAssetName));
     if (strlen(pIssuer) != 60){
         LOG("WARNING: Stop supporting hex format, please use qubic format 60-char length addresses\n");
-        exit(0);
+        cliExit(0);
     }
     getPublicKeyFromIdentity(pIssuer, issuer);
 
@@ -402,7 +411,7 @@ void qxGetAssetOrder(const char* nodeIp, int nodePort,
     packet.qgao.offset = offset;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -464,7 +473,7 @@ void qxGetEntityOrder(const char* nodeIp, int nodePort,
     uint8_t entity[32] = {0};
     if (strlen(pEntity) != 60){
         LOG("WARNING: Stop supporting hex format, please use qubic format 60-char length addresses\n");
-        exit(0);
+        cliExit(0);
     }
     getPublicKeyFromIdentity(pEntity, entity);
 
@@ -484,7 +493,7 @@ void qxGetEntityOrder(const char* nodeIp, int nodePort,
     packet.qgeo.offset = offset;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RespondContractFunction::type()});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
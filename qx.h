@@ -1,4 +1,5 @@
 #pragma once
+#include "connection.h"
 void qxIssueAsset(const char* nodeIp, int nodePort,
                   const char* seed,
                   const char* assetName,
@@ -16,6 +17,10 @@ void qxTransferAsset(const char* nodeIp, int nodePort,
                      uint32_t scheduledTickOffset);
 
 void printQxFee(const char* nodeIp, const int nodePort);
+void printQxFee(const QxFees_output& result);
+void getQxFees(QCPtr qc, QxFees_output& result);
+// Contract function request answered with QxFees_output
+RequestContractFunction getQxFeesRequest();
 
 void qxAddToAskOrder(const char* nodeIp, int nodePort,
                      const char* seed,
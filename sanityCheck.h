@@ -2,6 +2,8 @@
 
 
 #include <fstream>
+#include "nodeFanout.h"
+#include "daemon.h"
 
 static bool isValidIpAddress(char* ipAddress)
 {
@@ -22,7 +24,7 @@ static void sanityCheckTxType(uint16_t type)
     if (type > 1)
     {
         LOG("unknown input type %u\n", type);
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -31,11 +33,11 @@ static void sanityCheckSeed(char* privKey)
 	if (privKey == NULL)
 	{
 		LOG("privKey is null\n");
-		exit(1);
+		cliExit(1);
 	}
     if (strlen(privKey) != 55){
         LOG("Seed must be 55-char length\n");
-        exit(1);
+        cliExit(1);
     }
     if (memcmp(privKey, DEFAULT_SEED, 55) == 0){
         LOG("WARNING: You are using default seed\n");
@@ -47,25 +49,80 @@ static void sanityCheckNode(char* ip, int port)
 	if (port < 1024)
 	{
 		LOG("invalid port number\n");
-		exit(1);
+		cliExit(1);
 	}
 	if (ip == NULL)
 	{
 		LOG("invalid ipv4 address\n");
-		exit(1);
+		cliExit(1);
 	}
 	if (!isValidIpAddress(ip))
 	{
 		LOG("invalid ipv4 address: %s\n", ip);
-		exit(1);		
+		cliExit(1);		
 	}
 }
 
+static void sanityCheckNodeList(const std::vector<NodeAddress>& nodes)
+{
+    if (nodes.empty())
+    {
+        LOG("empty node list\n");
+        cliExit(1);
+    }
+    for (auto& node : nodes)
+    {
+        sanityCheckNode((char*)node.ip.c_str(), node.port);
+    }
+}
+
+static void sanityCheckCrawl(int depth, int width)
+{
+    if (depth < 0 || width <= 0)
+    {
+        LOG("depth must be positive or zero and width positive\n");
+        cliExit(1);
+    }
+}
+
+static void sanityCheckFileCount(int count)
+{
+    if (count <= 0)
+    {
+        LOG("At least one file is required\n");
+        cliExit(1);
+    }
+}
+
+static void sanityCheckTickRange(uint32_t fromTick, uint32_t toTick)
+{
+    // a negative tick parses to a huge one, UINT32_MAX would also make "tick <= toTick" loops endless
+    if (fromTick == 0 || fromTick > toTick || toTick == UINT32_MAX)
+    {
+        LOG("Invalid tick range %u to %u\n", fromTick, toTick);
+        cliExit(1);
+    }
+}
+
+static void sanityCheckJobs(int jobs, const char* replayFile)
+{
+    if (jobs <= 0)
+    {
+        LOG("-jobs must be positive\n");
+        cliExit(1);
+    }
+    if (jobs > 1 && replayFile != nullptr)
+    {
+        LOG("-replay needs the commands in recording order, it can not be combined with -jobs\n");
+        cliExit(1);
+    }
+}
+
 static void sanityCheckAmountTransferAsset(long long amount)
 {
     if (amount <= 0){
         LOG("Invalid amount\n");
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -73,30 +130,30 @@ static void sanityCheckIdentity(char* identity)
 {
 	if (identity == NULL){
 		LOG("identity is null\n");
-		exit(1);
+		cliExit(1);
 	}
 	for (int i = 0; i < 60; i++){
 		if (identity[i] < 'A' || identity[i] > 'Z'){
 			LOG("invalid identity at position %d (%c)", i, identity[i]);
-			exit(1);
+			cliExit(1);
 		}
 	}
     if (!checkSumIdentity(identity))
     {
         LOG("Identity checksum failed: %s\n", identity);
-        exit(1);
+        cliExit(1);
     }
 }
 static void sanityCheckTxHash(char* txHash)
 {
     if (txHash == NULL){
         LOG("identity is null\n");
-        exit(1);
+        cliExit(1);
     }
     for (int i = 0; i < 60; i++){
         if (txHash[i] < 'a' || txHash[i] > 'z'){
             LOG("invalid identity at position %d (%c)", i, txHash[i]);
-            exit(1);
+            cliExit(1);
         }
     }
 }
@@ -104,21 +161,21 @@ static void sanityCheckTxAmount(int64_t amount)
 {
 	if (amount < 0){
 		LOG("invalid amount %lld\n", amount);
-		exit(1);
+		cliExit(1);
 	}
 }
 static void sanityCheckExtraDataSize(int data_size)
 {
 	if (data_size > 1024){
 		LOG("Invalid data size %d, data size must be smaller than 1024\n", data_size);
-		exit(1);
+		cliExit(1);
 	}
 }
 static void sanityCheckRawPacketSize(int data_size)
 {
 	if (data_size > 1024){
 		LOG("Invalid data size %d, data size must be smaller than 1024\n", data_size);
-		exit(1);
+		cliExit(1);
 	}
 }
 
@@ -127,7 +184,7 @@ static void sanityFileExist (const std::string name) {
     if (!f.good())
     {
         LOG("File %s does not exist\n", name.c_str());
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -136,7 +193,7 @@ static void sanityCheckSpecialCommand(int cmd)
     if (cmd == -1)
     {
         LOG("Invalid special command");
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -144,7 +201,7 @@ static void sanityCheckNumberOfUnit(long long unit)
 {
     if (unit <= 0){
         LOG("Invalid number of unit\n");
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -152,7 +209,7 @@ static void sanityCheckNumberOfDecimal(char unit)
 {
     if (unit < 0){
         LOG("Invalid number of decimal\n");
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -160,14 +217,14 @@ static void sanityCheckValidString(const char* str)
 {
     if (str == nullptr){
         LOG("Invalid string\n");
-        exit(1);
+        cliExit(1);
     }
 }
 static void sanityCheckUnitofMeasurement(const char* str)
 {
     if (str == nullptr){
         LOG("Invalid string\n");
-        exit(1);
+        cliExit(1);
     }
     if (strlen(str) != 7){
         LOG("UnitofMeasurement length must be 7, they are powers of the corresponding SI base units:\n");
@@ -178,7 +235,7 @@ static void sanityCheckUnitofMeasurement(const char* str)
         LOG("METER\n");
         LOG("MOLE\n");
         LOG("SECOND\n");
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -186,22 +243,22 @@ static void sanityCheckMainAuxStatus(const char* str)
 {
     if (str == nullptr){
         LOG("Invalid MAIN/AUX string\n");
-        exit(1);
+        cliExit(1);
     }
     int len = strlen(str);
     if (len == 4){
         if (memcmp(str, "MAIN", 4) != 0){
             LOG("Invalid MAIN/AUX string. Expected (MAIN/AUX), have %s\n", str);
-            exit(1);
+            cliExit(1);
         }
     } else if (len == 3){
         if (memcmp(str, "AUX", 3) != 0){
             LOG("Invalid MAIN/AUX string. Expected (MAIN/AUX), have %s\n", str);
-            exit(1);
+            cliExit(1);
         }
     } else {
         LOG("Invalid MAIN/AUX string. Expected (MAIN/AUX), have %s\n", str);
-        exit(1);
+        cliExit(1);
     }
 }
 
@@ -211,7 +268,7 @@ static void checkValidEpoch(int epoch)
         return;
     }
     LOG("Invalid epoch number\n");
-    exit(1);
+    cliExit(1);
 }
 static void checkValidSolutionThreshold(int thres)
 {
@@ -219,5 +276,5 @@ static void checkValidSolutionThreshold(int thres)
         return;
     }
     LOG("Invalid solution threshold\n");
-    exit(1);
+    cliExit(1);
 }
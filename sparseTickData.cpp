@@ -0,0 +1,146 @@
+#include <cstring>
+#include "sparseTickData.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(TickDataHeader) == offsetof(TickData, transactionDigests), "TickDataHeader must match the start of TickData");
+
+// True if the 32 bytes at data are all zero
+static inline bool isZero32(const uint8_t* data)
+{
+#if defined(__AVX2__)
+    __m256i v = _mm256_loadu_si256((const __m256i*)data);
+    return _mm256_testz_si256(v, v);
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i*)data), _mm_loadu_si128((const __m128i*)(data + 16)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+#else
+    uint64_t words[4];
+    memcpy(words, data, 32);
+    return (words[0] | words[1] | words[2] | words[3]) == 0;
+#endif
+}
+
+static int popCount8(uint8_t value)
+{
+    int count = 0;
+    for (; value; value &= value - 1) count++;
+    return count;
+}
+
+bool SparseTickData::hasDigest(const uint8_t* digest) const
+{
+    for (size_t offset = 0; offset < digests.size(); offset += 32)
+    {
+        if (memcmp(digests.data() + offset, digest, 32) == 0) return true;
+    }
+    return false;
+}
+
+int scanTransactionDigests(const TickData& td, uint8_t* bitmap)
+{
+    int count = 0;
+    for (int i = 0; i < TICK_DIGEST_BITMAP_SIZE; i++)
+    {
+        uint8_t bits = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            if (!isZero32(td.transactionDigests[i * 8 + j])) bits |= 1 << j;
+        }
+        bitmap[i] = bits;
+        count += popCount8(bits);
+    }
+    return count;
+}
+
+void toSparseTickData(const TickData& td, SparseTickData& result)
+{
+    memcpy(&result.header, &td, sizeof(TickDataHeader));
+    int numTx = scanTransactionDigests(td, result.digestBitmap);
+    result.digests.resize(numTx * 32);
+    uint8_t* out = result.digests.data();
+    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK && numTx; i++)
+    {
+        if (!result.hasTransaction(i)) continue;
+        memcpy(out, td.transactionDigests[i], 32);
+        out += 32;
+        numTx--;
+    }
+    result.fees.clear();
+    // 4 fees per zero test
+    for (int i = 0; i < TICK_CONTRACT_FEE_COUNT; i += 4)
+    {
+        if (isZero32((const uint8_t*)&td.contractFees[i])) continue;
+        for (int j = i; j < i + 4; j++)
+        {
+            if (td.contractFees[j] == 0) continue;
+            SparseContractFee fee;
+            fee.index = uint16_t(j);
+            fee.fee = td.contractFees[j];
+            result.fees.push_back(fee);
+        }
+    }
+    memcpy(result.signature, td.signature, SIGNATURE_SIZE);
+}
+
+void fromSparseTickData(const SparseTickData& sparse, TickData& result)
+{
+    memset(&result, 0, sizeof(TickData));
+    memcpy(&result, &sparse.header, sizeof(TickDataHeader));
+    const uint8_t* digest = sparse.digests.data();
+    const uint8_t* end = digest + sparse.digests.size();
+    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK && digest < end; i++)
+    {
+        if (!sparse.hasTransaction(i)) continue;
+        memcpy(result.transactionDigests[i], digest, 32);
+        digest += 32;
+    }
+    for (auto& fee : sparse.fees)
+    {
+        if (fee.index < TICK_CONTRACT_FEE_COUNT) result.contractFees[fee.index] = fee.fee;
+    }
+    memcpy(result.signature, sparse.signature, SIGNATURE_SIZE);
+}
+
+size_t sparseTickDataSize(const SparseTickData& sparse)
+{
+    return sizeof(TickDataHeader) + TICK_DIGEST_BITMAP_SIZE + sparse.digests.size()
+           + sparse.fees.size() * sizeof(SparseContractFee) + SIGNATURE_SIZE;
+}
+
+void writeSparseTickData(const SparseTickData& sparse, std::vector<uint8_t>& out)
+{
+    size_t offset = out.size();
+    out.resize(offset + sparseTickDataSize(sparse));
+    uint8_t* ptr = out.data() + offset;
+    memcpy(ptr, &sparse.header, sizeof(TickDataHeader));
+    ptr += sizeof(TickDataHeader);
+    memcpy(ptr, sparse.digestBitmap, TICK_DIGEST_BITMAP_SIZE);
+    ptr += TICK_DIGEST_BITMAP_SIZE;
+    if (!sparse.digests.empty()) memcpy(ptr, sparse.digests.data(), sparse.digests.size());
+    ptr += sparse.digests.size();
+    if (!sparse.fees.empty()) memcpy(ptr, sparse.fees.data(), sparse.fees.size() * sizeof(SparseContractFee));
+    ptr += sparse.fees.size() * sizeof(SparseContractFee);
+    memcpy(ptr, sparse.signature, SIGNATURE_SIZE);
+}
+
+size_t readSparseTickData(const uint8_t* data, size_t size, int feeCount, SparseTickData& result)
+{
+    size_t fixedSize = sizeof(TickDataHeader) + TICK_DIGEST_BITMAP_SIZE;
+    if (size < fixedSize) return 0;
+    memcpy(&result.header, data, sizeof(TickDataHeader));
+    memcpy(result.digestBitmap, data + sizeof(TickDataHeader), TICK_DIGEST_BITMAP_SIZE);
+    int numTx = 0;
+    for (int i = 0; i < TICK_DIGEST_BITMAP_SIZE; i++) numTx += popCount8(result.digestBitmap[i]);
+    size_t total = fixedSize + numTx * 32 + feeCount * sizeof(SparseContractFee) + SIGNATURE_SIZE;
+    if (size < total) return 0;
+    const uint8_t* ptr = data + fixedSize;
+    result.digests.assign(ptr, ptr + numTx * 32);
+    ptr += numTx * 32;
+    result.fees.resize(feeCount);
+    if (feeCount) memcpy(result.fees.data(), ptr, feeCount * sizeof(SparseContractFee));
+    ptr += feeCount * sizeof(SparseContractFee);
+    memcpy(result.signature, ptr, SIGNATURE_SIZE);
+    return total;
+}
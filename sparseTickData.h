@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "structs.h"
+
+#define TICK_DIGEST_BITMAP_SIZE (NUMBER_OF_TRANSACTIONS_PER_TICK / 8)
+#define TICK_CONTRACT_FEE_COUNT 1024
+
+// The TickData fields before transactionDigests, same layout
+typedef struct
+{
+    unsigned short computorIndex;
+    unsigned short epoch;
+    unsigned int tick;
+
+    unsigned short millisecond;
+    unsigned char second;
+    unsigned char minute;
+    unsigned char hour;
+    unsigned char day;
+    unsigned char month;
+    unsigned char year;
+
+    union
+    {
+        struct
+        {
+            unsigned char uriSize;
+            unsigned char uri[255];
+        } proposal;
+        struct
+        {
+            unsigned char zero;
+            unsigned char votes[(676 * 3 + 7) / 8];
+            unsigned char quasiRandomNumber;
+        } ballot;
+    } varStruct;
+
+    unsigned char timelock[32];
+} TickDataHeader;
+
+#pragma pack(push, 1)
+struct SparseContractFee
+{
+    uint16_t index;
+    long long fee;
+};
+#pragma pack(pop)
+
+// TickData without its zero digests and fees: a tick carries a few transactions out of 1024 slots
+// and a handful of contract fees, so this is a few KB instead of 41 KB.
+struct SparseTickData
+{
+    TickDataHeader header;
+    uint8_t digestBitmap[TICK_DIGEST_BITMAP_SIZE]; // bit i set: transactionDigests[i] is not zero
+    std::vector<uint8_t> digests;                  // the non zero digests in slot order, 32 bytes each
+    std::vector<SparseContractFee> fees;           // the non zero contract fees
+    uint8_t signature[SIGNATURE_SIZE];
+
+    int numTx() const { return int(digests.size() / 32); }
+    bool hasTransaction(int slot) const { return (digestBitmap[slot >> 3] >> (slot & 7)) & 1; }
+    // True if digest is one of the transaction digests
+    bool hasDigest(const uint8_t* digest) const;
+};
+
+// Fills bitmap (TICK_DIGEST_BITMAP_SIZE bytes) with the non zero transaction digests of td, returns their count
+int scanTransactionDigests(const TickData& td, uint8_t* bitmap);
+void toSparseTickData(const TickData& td, SparseTickData& result);
+void fromSparseTickData(const SparseTickData& sparse, TickData& result);
+
+// On disk: TickDataHeader, bitmap, packed digests, fees, signature
+size_t sparseTickDataSize(const SparseTickData& sparse);
+void writeSparseTickData(const SparseTickData& sparse, std::vector<uint8_t>& out);
+// Reads what writeSparseTickData wrote, feeCount is not part of it. Returns the bytes read, 0 if data is too short
+size_t readSparseTickData(const uint8_t* data, size_t size, int feeCount, SparseTickData& result);
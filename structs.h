@@ -52,7 +52,20 @@ enum COMMAND
     GET_MINING_SCORE_RANKING=44,
     SEND_COIN_IN_TICK = 45,
     QUTIL_BURN_QUBIC=46,
-    TOTAL_COMMAND = 47, // DO NOT CHANGE THIS
+    GET_BALANCES = 47,
+    CRAWL_PEERS = 48,
+    RUN_DAEMON = 49,
+    RUN_BATCH = 50,
+    FOLLOW_TICKS = 51,
+    GET_TICK_DATA_RANGE = 52,
+    ARCHIVE_INFO = 53,
+    READ_ARCHIVE_TICK = 54,
+    CHECK_TX_ON_ARCHIVES = 55,
+    ARCHIVE_TICKS = 56,
+    VERIFY_TICK_FILES = 57,
+    QUORUM_RANGE = 58,
+    BUILD_TX_INDEX = 59,
+    TOTAL_COMMAND = 60, // DO NOT CHANGE THIS
 };
 
 struct RequestResponseHeader {
@@ -78,6 +91,16 @@ public:
         return !_dejavu;
     }
 
+    inline unsigned int dejavu()
+    {
+        return _dejavu;
+    }
+
+    inline void setDejavu(unsigned int dejavu)
+    {
+        _dejavu = dejavu;
+    }
+
     inline void zeroDejavu()
     {
         _dejavu = 0;
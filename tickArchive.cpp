@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include "tickArchive.h"
+#include "logger.h"
+#ifdef _MSC_VER
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void truncateFile(FILE* f, uint64_t size)
+{
+    fflush(f);
+#ifdef _MSC_VER
+    _chsize_s(_fileno(f), size);
+#else
+    if (ftruncate(fileno(f), size) != 0) LOG("Failed to truncate the archive\n");
+#endif
+    fseek(f, 0, SEEK_END);
+}
+
+static bool isValidRecord(const uint8_t* data, uint64_t size, uint64_t offset)
+{
+    if (offset + sizeof(TickRecordHeader) > size) return false;
+    auto record = (const TickRecordHeader*)(data + offset);
+    return record->size >= sizeof(TickRecordHeader) && offset + record->size <= size;
+}
+
+// True if offset is where the writer was killed while writing the index: the first entry (lowest tick) points
+// back at a record already scanned, a record could only look like that if its tick was archived twice
+static bool isIndexStart(const std::vector<TickArchiveIndexEntry>& scanned, const uint8_t* data, uint64_t size, uint64_t offset)
+{
+    if (offset + sizeof(TickArchiveIndexEntry) > size) return false;
+    TickArchiveIndexEntry entry;
+    memcpy(&entry, data + offset, sizeof(entry));
+    // scanned is still in file order, sorted by offset
+    auto it = std::lower_bound(scanned.begin(), scanned.end(), entry.offset, [](const TickArchiveIndexEntry& a, uint64_t value)
+    {
+        return a.offset < value;
+    });
+    return it != scanned.end() && it->offset == entry.offset && it->tick == entry.tick;
+}
+
+const uint8_t* tickRecordTransactions(const TickRecordHeader* record)
+{
+    return (const uint8_t*)(record + 1) + sizeof(TickDataHeader) + TICK_DIGEST_BITMAP_SIZE + record->numTx * 32
+           + record->feeCount * sizeof(SparseContractFee) + SIGNATURE_SIZE;
+}
+
+bool decodeTickRecord(const TickRecordHeader* record, FetchedTick& result)
+{
+    result.transactions.clear();
+    if (record->empty)
+    {
+        memset(&result.tickData.header, 0, sizeof(TickDataHeader));
+        memset(result.tickData.digestBitmap, 0, TICK_DIGEST_BITMAP_SIZE);
+        result.tickData.digests.clear();
+        result.tickData.fees.clear();
+        return true;
+    }
+    const uint8_t* ptr = (const uint8_t*)(record + 1);
+    const uint8_t* end = (const uint8_t*)record + record->size;
+    size_t used = readSparseTickData(ptr, end - ptr, record->feeCount, result.tickData);
+    if (used == 0 || result.tickData.numTx() != record->numTx) return false;
+    for (auto& fee : result.tickData.fees)
+    {
+        if (fee.index >= TICK_CONTRACT_FEE_COUNT) return false;
+    }
+    ptr += used;
+    for (int i = 0; i < record->txCount; i++)
+    {
+        if (ptr + sizeof(Transaction) > end) return false;
+        Transaction tx;
+        memcpy(&tx, ptr, sizeof(Transaction));
+        size_t txSize = sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE;
+        if (ptr + txSize > end) return false;
+        result.transactions.push_back(std::vector<uint8_t>(ptr, ptr + txSize));
+        ptr += txSize;
+    }
+    return true;
+}
+
+bool MappedFile::open(const char* fileName)
+{
+    close();
+#ifdef _MSC_VER
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = size.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (mapping == nullptr) return false;
+    mData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    mHandle = mapping;
+    mSize = size.QuadPart;
+    if (mData == nullptr)
+    {
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    fstat(fd, &st);
+    void* data = st.st_size ? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+    mData = (const uint8_t*)data;
+    mSize = st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData != nullptr)
+    {
+#ifdef _MSC_VER
+        UnmapViewOfFile(mData);
+#else
+        munmap((void*)mData, mSize);
+#endif
+    }
+#ifdef _MSC_VER
+    if (mHandle != nullptr) CloseHandle(mHandle);
+#endif
+    mData = nullptr;
+    mHandle = nullptr;
+    mSize = 0;
+}
+
+bool TickArchiveReader::open(const char* fileName)
+{
+    close();
+    if (!mFile.open(fileName)) return false;
+    const uint8_t* data = mFile.data();
+    uint64_t size = mFile.size();
+    auto header = (const TickArchiveHeader*)data;
+    if (size < sizeof(TickArchiveHeader) || memcmp(header->magic, TICK_ARCHIVE_MAGIC, 4) != 0 || header->version != TICK_ARCHIVE_VERSION)
+    {
+        close();
+        return false;
+    }
+
+    if (size >= sizeof(TickArchiveHeader) + sizeof(TickArchiveFooter))
+    {
+        auto footer = (const TickArchiveFooter*)(data + size - sizeof(TickArchiveFooter));
+        // compared without adding to the untrusted offset, which could wrap around
+        uint64_t indexEnd = size - sizeof(TickArchiveFooter);
+        uint64_t indexSize = uint64_t(footer->count) * sizeof(TickArchiveIndexEntry);
+        if (memcmp(footer->magic, TICK_ARCHIVE_INDEX_MAGIC, 4) == 0 && footer->indexOffset >= sizeof(TickArchiveHeader)
+            && footer->indexOffset <= indexEnd && indexEnd - footer->indexOffset == indexSize)
+        {
+            mRecordsEnd = footer->indexOffset;
+            mIndex.resize(footer->count);
+            if (footer->count) memcpy(mIndex.data(), data + footer->indexOffset, indexSize);
+            return true;
+        }
+    }
+
+    // no valid index: the writer did not close the archive, the records tell where the next one starts
+    uint64_t offset = sizeof(TickArchiveHeader);
+    while (isValidRecord(data, size, offset) && !isIndexStart(mIndex, data, size, offset))
+    {
+        auto record = (const TickRecordHeader*)(data + offset);
+        TickArchiveIndexEntry entry;
+        entry.tick = record->tick;
+        entry.offset = offset;
+        mIndex.push_back(entry);
+        offset += record->size;
+    }
+    mRecordsEnd = offset;
+    std::stable_sort(mIndex.begin(), mIndex.end(), [](const TickArchiveIndexEntry& a, const TickArchiveIndexEntry& b)
+    {
+        return a.tick < b.tick;
+    });
+    return true;
+}
+
+void TickArchiveReader::close()
+{
+    mFile.close();
+    mRecordsEnd = 0;
+    mIndex.clear();
+}
+
+uint16_t TickArchiveReader::epoch() const
+{
+    return mFile.data() ? ((const TickArchiveHeader*)mFile.data())->epoch : 0;
+}
+
+const TickRecordHeader* TickArchiveReader::findRecord(uint32_t tick) const
+{
+    if (mIndex.empty() || tick < mIndex[0].tick) return nullptr;
+    // ticks are mostly consecutive, then the entry is found right away
+    size_t guess = tick - mIndex[0].tick;
+    size_t i;
+    if (guess < mIndex.size() && mIndex[guess].tick == tick)
+    {
+        i = guess;
+    }
+    else
+    {
+        auto it = std::lower_bound(mIndex.begin(), mIndex.end(), tick, [](const TickArchiveIndexEntry& entry, uint32_t value)
+        {
+            return entry.tick < value;
+        });
+        if (it == mIndex.end() || it->tick != tick) return nullptr;
+        i = it - mIndex.begin();
+    }
+    if (!isValidRecord(mFile.data(), mRecordsEnd, mIndex[i].offset)) return nullptr;
+    return (const TickRecordHeader*)(mFile.data() + mIndex[i].offset);
+}
+
+TickFetchResult TickArchiveReader::readTick(uint32_t tick, FetchedTick& result) const
+{
+    auto record = findRecord(tick);
+    if (record == nullptr || !decodeTickRecord(record, result))
+    {
+        result.transactions.clear();
+        return TICK_NOT_REACHED;
+    }
+    return record->empty ? TICK_EMPTY : TICK_FETCHED;
+}
+
+bool TickArchiveWriter::open(const char* fileName)
+{
+    close();
+    uint64_t recordsEnd = 0;
+    {
+        TickArchiveReader reader;
+        if (reader.open(fileName))
+        {
+            mIndex = reader.index();
+            for (auto& entry : mIndex) mTicks.insert(entry.tick);
+            mEpoch = reader.epoch();
+            recordsEnd = reader.recordsEnd();
+        }
+        else
+        {
+            FILE* existing = fopen(fileName, "rb");
+            if (existing != nullptr)
+            {
+                bool isEmpty = fgetc(existing) == EOF;
+                fclose(existing);
+                if (!isEmpty)
+                {
+                    LOG("%s is not a tick archive\n", fileName);
+                    return false;
+                }
+            }
+        }
+    }
+    mFile = fopen(fileName, recordsEnd ? "r+b" : "wb");
+    if (mFile == nullptr)
+    {
+        LOG("Failed to open %s\n", fileName);
+        mIndex.clear();
+        mTicks.clear();
+        return false;
+    }
+    if (recordsEnd)
+    {
+        // the index is written again on close, new records go where it was
+        truncateFile(mFile, recordsEnd);
+    }
+    else
+    {
+        TickArchiveHeader header;
+        memcpy(header.magic, TICK_ARCHIVE_MAGIC, 4);
+        header.version = TICK_ARCHIVE_VERSION;
+        header.epoch = 0;
+        header.reserved = 0;
+        fwrite(&header, 1, sizeof(header), mFile);
+        mEpoch = 0;
+    }
+    return true;
+}
+
+bool TickArchiveWriter::contains(uint32_t tick) const
+{
+    return mTicks.count(tick) != 0;
+}
+
+bool TickArchiveWriter::writeRecord(const TickRecordHeader& header, const std::vector<uint8_t>& body)
+{
+    TickArchiveIndexEntry entry;
+    entry.tick = header.tick;
+    fseek(mFile, 0, SEEK_END);
+    entry.offset = ftell(mFile);
+    if (fwrite(&header, 1, sizeof(header), mFile) != sizeof(header)
+        || (body.size() && fwrite(body.data(), 1, body.size(), mFile) != body.size()))
+    {
+        LOG("Failed to write tick %u to the archive\n", header.tick);
+        return false;
+    }
+    mIndex.push_back(entry);
+    mTicks.insert(entry.tick);
+    return true;
+}
+
+bool TickArchiveWriter::append(const FetchedTick& tick)
+{
+    const SparseTickData& td = tick.tickData;
+    if (mEpoch == 0)
+    {
+        mEpoch = td.header.epoch;
+        fseek(mFile, offsetof(TickArchiveHeader, epoch), SEEK_SET);
+        fwrite(&mEpoch, 1, sizeof(mEpoch), mFile);
+    }
+    else if (td.header.epoch != mEpoch)
+    {
+        LOG("Tick %u is from epoch %u, the archive holds epoch %u\n", td.header.tick, td.header.epoch, mEpoch);
+        return false;
+    }
+
+    std::vector<uint8_t> body;
+    writeSparseTickData(td, body);
+    for (auto& tx : tick.transactions) body.insert(body.end(), tx.begin(), tx.end());
+
+    TickRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.tick = td.header.tick;
+    header.size = uint32_t(sizeof(header) + body.size());
+    header.numTx = uint16_t(td.numTx());
+    header.txCount = uint16_t(tick.transactions.size());
+    header.feeCount = uint16_t(td.fees.size());
+    return writeRecord(header, body);
+}
+
+bool TickArchiveWriter::appendEmpty(uint32_t tick)
+{
+    TickRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.tick = tick;
+    header.size = sizeof(header);
+    header.empty = 1;
+    return writeRecord(header, std::vector<uint8_t>());
+}
+
+void TickArchiveWriter::close()
+{
+    if (mFile == nullptr) return;
+    std::stable_sort(mIndex.begin(), mIndex.end(), [](const TickArchiveIndexEntry& a, const TickArchiveIndexEntry& b)
+    {
+        return a.tick < b.tick;
+    });
+    fseek(mFile, 0, SEEK_END);
+    TickArchiveFooter footer;
+    footer.indexOffset = ftell(mFile);
+    footer.count = uint32_t(mIndex.size());
+    memcpy(footer.magic, TICK_ARCHIVE_INDEX_MAGIC, 4);
+    if (!mIndex.empty()) fwrite(mIndex.data(), sizeof(TickArchiveIndexEntry), mIndex.size(), mFile);
+    fwrite(&footer, 1, sizeof(footer), mFile);
+    fclose(mFile);
+    mFile = nullptr;
+    mIndex.clear();
+    mTicks.clear();
+    mEpoch = 0;
+}
+
+void printTickArchiveInfo(const char* fileName)
+{
+    TickArchiveReader reader;
+    if (!reader.open(fileName))
+    {
+        LOG("%s is not a tick archive\n", fileName);
+        return;
+    }
+    auto& index = reader.index();
+    uint64_t rawSize = 0;
+    int empty = 0, txs = 0;
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    for (auto& entry : index)
+    {
+        auto record = reader.findRecord(entry.tick);
+        if (record == nullptr || !decodeTickRecord(record, *fetched)) continue;
+        if (record->empty)
+        {
+            empty++;
+            continue;
+        }
+        rawSize += sizeof(TickData);
+        for (auto& tx : fetched->transactions) rawSize += tx.size();
+        txs += int(fetched->transactions.size());
+    }
+    LOG("Epoch: %u\n", reader.epoch());
+    if (!index.empty()) LOG("Ticks: %u to %u\n", index.front().tick, index.back().tick);
+    LOG("Archived ticks: %d (%d empty)\n", int(index.size()), empty);
+    LOG("Transactions: %d\n", txs);
+    LOG("Size: %llu bytes, %llu bytes as -gettickdata files\n", (unsigned long long)reader.fileSize(), (unsigned long long)rawSize);
+}
+
+void extractTickFromArchive(const char* archiveFile, uint32_t tick, const char* fileName)
+{
+    TickArchiveReader reader;
+    if (!reader.open(archiveFile))
+    {
+        LOG("%s is not a tick archive\n", archiveFile);
+        return;
+    }
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    switch (reader.readTick(tick, *fetched))
+    {
+        case TICK_NOT_REACHED:
+            LOG("Tick %u is not in %s\n", tick, archiveFile);
+            return;
+        case TICK_EMPTY:
+            LOG("Tick %u is empty\n", tick);
+            return;
+        case TICK_FETCHED:
+            break;
+    }
+    FILE* f = fopen(fileName, "wb");
+    if (f == nullptr)
+    {
+        LOG("Failed to open %s\n", fileName);
+        return;
+    }
+    writeFetchedTick(f, *fetched);
+    fclose(f);
+    LOG("Tick data and tick transactions have been written to %s\n", fileName);
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <vector>
+#include "nodeUtils.h"
+
+// Tick archive: all ticks of one epoch in one append-only file.
+//  - TickArchiveHeader
+//  - one record per tick: TickRecordHeader, then unless empty the tick data as written by
+//    writeSparseTickData (TickDataHeader, digest bitmap, packed digests, non zero contract fees, signature)
+//    and the raw transactions (Transaction, input, signature)
+//  - index: one TickArchiveIndexEntry per record sorted by tick, then TickArchiveFooter
+// The index is rewritten each time the archive is closed after appending. Without a valid footer (the writer
+// was killed) the records are scanned instead, they carry their own size, up to a partly written index.
+#define TICK_ARCHIVE_MAGIC "QTAR"
+#define TICK_ARCHIVE_INDEX_MAGIC "QTIX"
+#define TICK_ARCHIVE_VERSION 1
+
+#pragma pack(push, 1)
+struct TickArchiveHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint16_t epoch;
+    uint16_t reserved;
+};
+
+struct TickRecordHeader
+{
+    uint32_t tick;
+    uint32_t size;     // whole record, header included
+    uint16_t numTx;    // transactions announced by the tick data
+    uint16_t txCount;  // transactions stored
+    uint16_t feeCount; // non zero contract fees stored
+    uint8_t empty;     // the node had no tick data for this tick, nothing follows
+    uint8_t reserved;
+};
+
+struct TickArchiveIndexEntry
+{
+    uint32_t tick;
+    uint64_t offset;
+};
+
+struct TickArchiveFooter
+{
+    uint64_t indexOffset;
+    uint32_t count;
+    char magic[4];
+};
+#pragma pack(pop)
+
+// Read only memory map of a whole file
+class MappedFile
+{
+public:
+    MappedFile() : mData(nullptr), mSize(0), mHandle(nullptr) {}
+    ~MappedFile() { close(); }
+
+    // False if the file cannot be opened or is empty
+    bool open(const char* fileName);
+    void close();
+    const uint8_t* data() const { return mData; }
+    uint64_t size() const { return mSize; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const uint8_t* mData;
+    uint64_t mSize;
+    void* mHandle;
+};
+
+// Appends ticks to an archive, creating it if needed
+class TickArchiveWriter
+{
+public:
+    TickArchiveWriter() : mFile(nullptr), mEpoch(0) {}
+    ~TickArchiveWriter() { close(); }
+
+    // Opens fileName for appending, drops its footer and an incomplete last record. False if it is not an archive
+    bool open(const char* fileName);
+    // False if tick belongs to another epoch than the ticks already archived
+    bool append(const FetchedTick& tick);
+    bool appendEmpty(uint32_t tick);
+    bool contains(uint32_t tick) const;
+    // Epoch of the archived ticks, 0 while there are none
+    uint16_t epoch() const { return mEpoch; }
+    // Makes the records appended so far survive a crash, the index is still only written by close
+    void flush() { if (mFile) fflush(mFile); }
+    // Writes the index, the archive can be read again after this
+    void close();
+
+private:
+    bool writeRecord(const TickRecordHeader& header, const std::vector<uint8_t>& body);
+
+    FILE* mFile;
+    uint16_t mEpoch;
+    std::vector<TickArchiveIndexEntry> mIndex;
+    std::set<uint32_t> mTicks;
+};
+
+// Reads an archive through a memory map, ticks are found through the index without reading other records
+class TickArchiveReader
+{
+public:
+    TickArchiveReader() : mRecordsEnd(0) {}
+    ~TickArchiveReader() { close(); }
+
+    bool open(const char* fileName);
+    void close();
+    uint16_t epoch() const;
+    const std::vector<TickArchiveIndexEntry>& index() const { return mIndex; }
+    // TICK_FETCHED or TICK_EMPTY as when it was archived, TICK_NOT_REACHED if the archive does not have tick
+    TickFetchResult readTick(uint32_t tick, FetchedTick& result) const;
+    // The record of tick, nullptr if the archive does not have it
+    const TickRecordHeader* findRecord(uint32_t tick) const;
+    uint64_t fileSize() const { return mFile.size(); }
+    // Offset where the index starts, or would start
+    uint64_t recordsEnd() const { return mRecordsEnd; }
+    // The whole archive, record offsets of the index point into it
+    const uint8_t* data() const { return mFile.data(); }
+
+private:
+    MappedFile mFile;
+    uint64_t mRecordsEnd;
+    std::vector<TickArchiveIndexEntry> mIndex;
+};
+
+// Start of the raw transactions of a non empty record
+const uint8_t* tickRecordTransactions(const TickRecordHeader* record);
+// Decodes a record into result, false if it is malformed
+bool decodeTickRecord(const TickRecordHeader* record, FetchedTick& result);
+// Prints epoch, ticks and size of an archive
+void printTickArchiveInfo(const char* fileName);
+// Writes one tick of an archive in the -gettickdata file format
+void extractTickFromArchive(const char* archiveFile, uint32_t tick, const char* fileName);
@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include "tickFetcher.h"
+#include "connection.h"
+#include "nodeUtils.h"
+#include "quorumUtils.h"
+#include "tickArchive.h"
+#include "keyUtils.h"
+#include "K12AndKeyUtil.h"
+#include "logger.h"
+
+static void printFetchedTick(const FetchedTick& fetched)
+{
+    const TickDataHeader& td = fetched.tickData.header;
+    LOG("tick %u epoch %u time 20%02d-%02d-%02d %02d:%02d:%02d.%03d txs %d/%d\n", td.tick, td.epoch,
+        td.year, td.month, td.day, td.hour, td.minute, td.second, td.millisecond,
+        int(fetched.transactions.size()), fetched.tickData.numTx());
+    for (auto& raw : fetched.transactions)
+    {
+        auto tx = (const Transaction*)raw.data();
+        uint8_t digest[32];
+        char txHash[128] = {0};
+        char source[128] = {0};
+        char destination[128] = {0};
+        KangarooTwelve(raw.data(), raw.size(), digest, 32);
+        getTxHashFromDigest(digest, txHash);
+        getIdentityFromPublicKey(tx->sourcePublicKey, source, false);
+        getIdentityFromPublicKey(tx->destinationPublicKey, destination, false);
+        LOG("tx %s %u %s %s %lld %u %u\n", txHash, tx->tick, source, destination, tx->amount, tx->inputType, tx->inputSize);
+    }
+}
+
+void followTicks(const char* nodeIp, int nodePort, uint32_t startTick, const char* fileName)
+{
+    FILE* f = nullptr;
+    if (fileName != nullptr && strcmp(fileName, "-") != 0)
+    {
+        f = fopen(fileName, "ab");
+        if (f == nullptr)
+        {
+            LOG("Failed to open %s\n", fileName);
+            return;
+        }
+    }
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    uint32_t nextTick = startTick;
+    QCPtr qc;
+    while (true)
+    {
+        try
+        {
+            if (!qc) qc = make_qc(nodeIp, nodePort);
+            CurrentTickInfo info = getTickInfoFromNode(qc);
+            if (nextTick == 0) nextTick = info.tick;
+            if (info.initialTick > nextTick)
+            {
+                // ticks before the initial tick of the epoch are no longer served
+                LOG("Skipping ticks %u to %u, the node starts at tick %u\n", nextTick, info.initialTick - 1, info.initialTick);
+                nextTick = info.initialTick;
+            }
+            // a tick is only final once the node is past it
+            while (nextTick < info.tick)
+            {
+                TickFetchResult result = fetchTickFromNode(qc, nextTick, info.tick, *fetched);
+                if (result == TICK_FETCHED)
+                {
+                    if (f) writeFetchedTick(f, *fetched);
+                    else printFetchedTick(*fetched);
+                }
+                else if (!f)
+                {
+                    LOG("tick %u empty\n", nextTick);
+                }
+                nextTick++;
+            }
+            if (f) fflush(f);
+            fflush(stdout);
+        }
+        catch (std::logic_error& e)
+        {
+            LOG("%s Reconnecting to %s:%d\n", e.what(), nodeIp, nodePort);
+            qc.reset();
+            std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_RECONNECT_MS));
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MS));
+    }
+}
+
+static uint32_t readCheckpoint(const std::string& fileName)
+{
+    unsigned int tick = 0;
+    FILE* f = fopen(fileName.c_str(), "r");
+    if (f == nullptr) return 0;
+    if (fscanf(f, "%u", &tick) != 1) tick = 0;
+    fclose(f);
+    return tick;
+}
+
+static void writeCheckpoint(const std::string& fileName, uint32_t tick)
+{
+    FILE* f = fopen((fileName + ".part").c_str(), "w");
+    if (f == nullptr) return;
+    fprintf(f, "%u\n", tick);
+    fclose(f);
+    remove(fileName.c_str());
+    rename((fileName + ".part").c_str(), fileName.c_str());
+}
+
+void archiveTicks(const char* nodeIp, int nodePort, const char* archiveFile, uint32_t startTick)
+{
+    TickArchiveWriter archive;
+    if (!archive.open(archiveFile)) return;
+    std::string checkpointFile = std::string(archiveFile) + ARCHIVE_CHECKPOINT_EXTENSION;
+    uint32_t checkpoint = readCheckpoint(checkpointFile);
+    uint32_t nextTick = checkpoint ? checkpoint + 1 : startTick;
+    if (checkpoint) LOG("Resuming %s after tick %u\n", archiveFile, checkpoint);
+
+    std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+    std::unique_ptr<BroadcastComputors> bc(new BroadcastComputors);
+    ComputorListPtr computors;
+    int attempts = 0;
+    int unconfirmedPolls = 0; // of nextTick, an empty tick waiting for its quorum
+    QCPtr qc;
+    while (true)
+    {
+        int pollMs = FOLLOW_POLL_MS;
+        try
+        {
+            if (!qc) qc = make_qc(nodeIp, nodePort);
+            CurrentTickInfo info = getTickInfoFromNode(qc);
+            if (archive.epoch() && info.epoch != archive.epoch())
+            {
+                LOG("Epoch %u is over, %s is complete up to tick %u\n", archive.epoch(), archiveFile, nextTick - 1);
+                break;
+            }
+            if (nextTick == 0) nextTick = info.tick;
+            if (info.initialTick > nextTick)
+            {
+                LOG("Skipping ticks %u to %u, the node starts at tick %u\n", nextTick, info.initialTick - 1, info.initialTick);
+                nextTick = info.initialTick;
+            }
+            if (!computors || computors->epoch() != info.epoch)
+            {
+                if (!getComputorFromNode(nodeIp, nodePort, *bc)) throw std::logic_error("Failed to get the computor list.");
+                computors = getComputorList(*bc);
+            }
+            // a tick is only final once the node is past it
+            bool waiting = false;
+            bool unconfirmed = false;
+            while (nextTick < info.tick && !waiting)
+            {
+                if (archive.contains(nextTick))
+                {
+                    nextTick++;
+                    continue;
+                }
+                bool archived = false;
+                switch (fetchTickFromNode(qc, nextTick, info.tick, *fetched))
+                {
+                    case TICK_NOT_REACHED:
+                        waiting = true;
+                        break;
+                    case TICK_EMPTY:
+                        // the tick data may still be on its way to the node, the tick is only empty for good once
+                        // its quorum voted for no tick data
+                        if (info.tick - nextTick < ARCHIVE_EMPTY_SETTLE_TICKS)
+                        {
+                            waiting = true;
+                            break;
+                        }
+                        switch (checkEmptyTickQuorum(qc, nextTick, *computors))
+                        {
+                            case EMPTY_TICK_CONFIRMED:
+                                archived = archive.appendEmpty(nextTick);
+                                break;
+                            case EMPTY_TICK_HAS_DATA:
+                                if (!unconfirmedPolls) LOG("Tick %u has tick data by its quorum, the node does not have it, waiting\n", nextTick);
+                                unconfirmed = true;
+                                break;
+                            case EMPTY_TICK_NO_QUORUM:
+                                if (!unconfirmedPolls) LOG("Tick %u has no tick data and no quorum of votes for an empty tick yet, waiting\n", nextTick);
+                                unconfirmed = true;
+                                break;
+                        }
+                        break;
+                    case TICK_FETCHED:
+                        switch (verifyFetchedTick(*fetched, *computors))
+                        {
+                            case TICK_VERIFIED:
+                                archived = archive.append(*fetched);
+                                break;
+                            case TICK_BAD_SIGNATURE:
+                                LOG("Tick %u is not signed by its computor\n", nextTick);
+                                break;
+                            case TICK_MISSING_TRANSACTIONS:
+                                LOG("Tick %u is missing transactions (%d of %d received)\n", nextTick,
+                                    int(fetched->transactions.size()), fetched->tickData.numTx());
+                                break;
+                            case TICK_UNEXPECTED_TRANSACTIONS:
+                                LOG("Tick %u came with transactions it does not announce\n", nextTick);
+                                break;
+                        }
+                        break;
+                }
+                if (archived)
+                {
+                    nextTick++;
+                    attempts = 0;
+                    unconfirmedPolls = 0;
+                    continue;
+                }
+                if (waiting) break;
+                if (unconfirmed)
+                {
+                    // the votes may still come in or reach the node, that is no failure of the tick: asked again
+                    // less and less often instead of giving up on it
+                    pollMs = std::min(FOLLOW_POLL_MS << std::min(unconfirmedPolls, 16), ARCHIVE_UNCONFIRMED_MAX_POLL_MS);
+                    unconfirmedPolls++;
+                    break;
+                }
+                if (++attempts >= ARCHIVE_MAX_ATTEMPTS)
+                {
+                    LOG("Giving up on tick %u after %d attempts, %s is complete up to tick %u\n", nextTick, attempts, archiveFile, nextTick - 1);
+                    archive.close();
+                    writeCheckpoint(checkpointFile, nextTick - 1);
+                    return;
+                }
+                waiting = true;
+            }
+            archive.flush();
+            if (nextTick > 1) writeCheckpoint(checkpointFile, nextTick - 1);
+        }
+        catch (std::logic_error& e)
+        {
+            LOG("%s Reconnecting to %s:%d\n", e.what(), nodeIp, nodePort);
+            qc.reset();
+            std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_RECONNECT_MS));
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+    }
+    archive.close();
+    writeCheckpoint(checkpointFile, nextTick - 1);
+}
+
+namespace
+{
+    // Spaces requests of all workers evenly, rate per second
+    class RateLimiter
+    {
+    public:
+        explicit RateLimiter(int rate) : mInterval(rate > 0 ? std::chrono::microseconds(1000000 / rate) : std::chrono::microseconds(0)),
+                                         mNext(std::chrono::steady_clock::now()) {}
+
+        void acquire()
+        {
+            if (mInterval.count() == 0) return;
+            std::chrono::steady_clock::time_point slot;
+            {
+                std::lock_guard<std::mutex> guard(mLock);
+                auto now = std::chrono::steady_clock::now();
+                if (mNext < now) mNext = now;
+                slot = mNext;
+                mNext += mInterval;
+            }
+            std::this_thread::sleep_until(slot);
+        }
+
+    private:
+        std::mutex mLock;
+        std::chrono::microseconds mInterval;
+        std::chrono::steady_clock::time_point mNext;
+    };
+
+    enum RangeTickState
+    {
+        RANGE_PENDING,
+        RANGE_FETCHED,
+        RANGE_EMPTY,       // no tick data, confirmed by the quorum
+        RANGE_UNCONFIRMED, // no tick data, but no quorum voted for an empty tick: not kept, a resume asks again
+        RANGE_FAILED,
+    };
+
+    bool isDirectory(const char* path)
+    {
+        struct stat st;
+        return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+    }
+
+    bool fileExists(const std::string& path)
+    {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0;
+    }
+}
+
+void getTickDataRange(const std::vector<NodeAddress>& nodes, uint32_t fromTick, uint32_t toTick, const char* output,
+                      int jobs, int rateLimit)
+{
+    bool directory = isDirectory(output);
+    TickArchiveWriter archive;
+    if (!directory && !archive.open(output)) return;
+    std::vector<uint32_t> ticks;
+    uint32_t skipped = 0;
+    for (uint64_t t = fromTick; t <= toTick; t++)
+    {
+        uint32_t tick = uint32_t(t);
+        std::string path = std::string(output) + "/" + std::to_string(tick);
+        bool done = directory ? fileExists(path + ".bin") || fileExists(path + RANGE_EMPTY_EXTENSION) : archive.contains(tick);
+        if (done) skipped++;
+        else ticks.push_back(tick);
+    }
+    LOG("Fetching %d ticks from %u to %u with %d connections to %d nodes (%u already present)\n", int(ticks.size()),
+        fromTick, toTick, jobs, int(nodes.size()), skipped);
+
+    RateLimiter limiter(rateLimit);
+    std::atomic<size_t> next(0);
+    std::mutex lock;
+    std::vector<RangeTickState> states(ticks.size(), RANGE_PENDING);
+    std::vector<std::unique_ptr<FetchedTick>> results(ticks.size());
+    size_t written = 0; // archive mode: ticks before this index are archived, or failed
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](const NodeAddress& node)
+    {
+        QCPtr qc;
+        uint32_t currentTick = 0;
+        ComputorListPtr computors;
+        for (size_t i = next++; i < ticks.size(); i = next++)
+        {
+            std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+            RangeTickState state = RANGE_FAILED;
+            bool unconfirmed = false;
+            for (int attempt = 1; attempt <= RANGE_MAX_ATTEMPTS && state == RANGE_FAILED; attempt++)
+            {
+                try
+                {
+                    if (!qc) qc = make_qc(node.ip.c_str(), node.port);
+                    limiter.acquire();
+                    if (currentTick <= ticks[i]) currentTick = getTickNumberFromNode(qc);
+                    // like for -followticks, a tick is only final once the node is past it
+                    switch (fetchTickFromNode(qc, ticks[i], currentTick == ticks[i] ? 0 : currentTick, *fetched))
+                    {
+                        case TICK_FETCHED: state = RANGE_FETCHED; break;
+                        case TICK_EMPTY:
+                            // the tick data may still be on its way to the node, only the quorum makes the tick empty
+                            if (!computors)
+                            {
+                                std::unique_ptr<BroadcastComputors> bc(new BroadcastComputors);
+                                if (!getComputorFromNode(node.ip.c_str(), node.port, *bc))
+                                {
+                                    throw std::logic_error("Failed to get the computor list.");
+                                }
+                                computors = getComputorList(*bc);
+                            }
+                            if (checkEmptyTickQuorum(qc, ticks[i], *computors) == EMPTY_TICK_CONFIRMED) state = RANGE_EMPTY;
+                            else unconfirmed = true;
+                            break;
+                        case TICK_NOT_REACHED: break;
+                    }
+                }
+                catch (std::logic_error&)
+                {
+                    qc.reset();
+                }
+                if (state == RANGE_FAILED && attempt < RANGE_MAX_ATTEMPTS)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(RANGE_RETRY_MS * attempt));
+                }
+            }
+            if (state == RANGE_FAILED && unconfirmed) state = RANGE_UNCONFIRMED;
+            if (directory && state == RANGE_FETCHED)
+            {
+                // written under another name first, so an interrupted write is not taken for a complete tick on resume
+                std::string path = std::string(output) + "/" + std::to_string(ticks[i]) + ".bin";
+                FILE* f = fopen((path + ".part").c_str(), "wb");
+                if (f == nullptr)
+                {
+                    state = RANGE_FAILED;
+                }
+                else
+                {
+                    writeFetchedTick(f, *fetched);
+                    fclose(f);
+                    remove(path.c_str());
+                    if (rename((path + ".part").c_str(), path.c_str()) != 0) state = RANGE_FAILED;
+                }
+            }
+            if (directory && state == RANGE_EMPTY)
+            {
+                // only spares asking for the tick again on resume, the tick stays empty if the marker can not be written
+                std::string path = std::string(output) + "/" + std::to_string(ticks[i]) + RANGE_EMPTY_EXTENSION;
+                FILE* f = fopen(path.c_str(), "wb");
+                if (f != nullptr) fclose(f);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            states[i] = state;
+            if (!directory)
+            {
+                if (state == RANGE_FETCHED || state == RANGE_EMPTY) results[i] = std::move(fetched);
+                // archived in tick order, confirmed empty ticks too so that they are not asked again on resume
+                for (; written < ticks.size() && states[written] != RANGE_PENDING; written++)
+                {
+                    if (!results[written]) continue;
+                    bool archived = states[written] == RANGE_EMPTY ? archive.appendEmpty(ticks[written]) : archive.append(*results[written]);
+                    if (!archived) states[written] = RANGE_FAILED;
+                    results[written].reset();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < jobs && t < int(ticks.size()); t++)
+    {
+        workers.emplace_back(worker, nodes[t % nodes.size()]);
+    }
+    for (auto& thread : workers) thread.join();
+    archive.close();
+
+    int fetched = 0, empty = 0;
+    std::string failed, unconfirmed;
+    for (size_t i = 0; i < ticks.size(); i++)
+    {
+        if (states[i] == RANGE_FETCHED) fetched++;
+        else if (states[i] == RANGE_EMPTY) empty++;
+        else if (states[i] == RANGE_UNCONFIRMED) unconfirmed += " " + std::to_string(ticks[i]);
+        else failed += " " + std::to_string(ticks[i]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("%d ticks fetched, %d empty, %d failed in %.1fs (%.1f ticks/s)\n", fetched, empty, int(ticks.size()) - fetched - empty,
+        seconds, seconds > 0 ? ticks.size() / seconds : 0.0);
+    if (!unconfirmed.empty()) LOG("Ticks without tick data and without a quorum for an empty tick:%s\n", unconfirmed.c_str());
+    if (!failed.empty()) LOG("Failed ticks:%s\n", failed.c_str());
+    if (!failed.empty() || !unconfirmed.empty()) LOG("Run the same command again to retry them.\n");
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "nodeFanout.h"
+
+#define FOLLOW_POLL_MS 250       // how often the node is asked for its current tick while waiting for the next one
+#define FOLLOW_RECONNECT_MS 1000 // pause before reconnecting after a connection error
+#define RANGE_MAX_ATTEMPTS 5     // attempts per tick before -gettickdatarange gives up on it
+#define RANGE_RETRY_MS 500       // pause after a failed attempt, multiplied by the attempt number
+#define ARCHIVE_EMPTY_SETTLE_TICKS 5 // the quorum of a tick without tick data is asked once the node is this far past it
+#define ARCHIVE_MAX_ATTEMPTS 20      // fetches of one tick before -archiveticks gives up
+#define ARCHIVE_UNCONFIRMED_MAX_POLL_MS 30000 // the quorum of an unconfirmed empty tick is asked again at least this often
+#define ARCHIVE_CHECKPOINT_EXTENSION ".checkpoint"
+#define RANGE_EMPTY_EXTENSION ".empty" // -gettickdatarange directory mode: zero length <TICK>.empty for an empty tick
+
+// Streams every tick from startTick on (the node's current tick when 0) as soon as the node is past it, until killed.
+// With fileName nullptr or "-" a line per tick and per transaction is printed, otherwise every non empty tick
+// is appended to fileName in the -gettickdata file format.
+void followTicks(const char* nodeIp, int nodePort, uint32_t startTick, const char* fileName);
+
+// Archives every tick from startTick on (the node's current tick when 0) into the tick archive archiveFile, until the
+// epoch ends. Only ticks whose tick data is signed by its computor and whose transactions are all there are archived,
+// ticks without tick data once the node is ARCHIVE_EMPTY_SETTLE_TICKS past them and a quorum of computors voted a zero
+// transaction digest for them. A tick that stays unverified for ARCHIVE_MAX_ATTEMPTS fetches ends the run, an empty tick
+// without such a quorum yet is waited for, asked again at growing intervals. <archiveFile>.checkpoint holds the last tick up to which the archive is complete, it never passes such a tick:
+// a restarted run continues after it, fetches that tick again and skips ticks already archived.
+void archiveTicks(const char* nodeIp, int nodePort, const char* archiveFile, uint32_t startTick);
+
+// Fetches ticks fromTick to toTick with jobs connections spread over nodes, at most rateLimit ticks per second (0: no limit).
+// output is either an existing directory, receiving one <TICK>.bin file per tick in the -gettickdata file format
+// (and an empty <TICK>.empty file per empty tick), or a tick archive (tickArchive.h) the ticks are appended to in
+// tick order. A tick without tick data is only kept as empty once a quorum of computors voted for no tick data
+// (checkEmptyTickQuorum), otherwise it is reported and left out. Ticks already in output, empty ones included, are
+// skipped, so an interrupted download is resumed by running the same command again.
+void getTickDataRange(const std::vector<NodeAddress>& nodes, uint32_t fromTick, uint32_t toTick, const char* output,
+                      int jobs, int rateLimit);
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include "tickVerifier.h"
+#include "tickArchive.h"
+#include "K12AndKeyUtil.h"
+#include "logger.h"
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace
+{
+    enum TickFileState
+    {
+        TICK_FILE_AUDITED,
+        TICK_FILE_EMPTY,
+        TICK_FILE_UNREADABLE,
+    };
+
+    bool isDirectory(const char* path)
+    {
+        struct stat st;
+        return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+    }
+
+    // The *.bin files of directory, by tick number
+    std::vector<std::string> listTickFiles(const char* directory)
+    {
+        std::vector<std::string> names;
+#ifdef _MSC_VER
+        WIN32_FIND_DATAA entry;
+        HANDLE find = FindFirstFileA((std::string(directory) + "\\*.bin").c_str(), &entry);
+        if (find != INVALID_HANDLE_VALUE)
+        {
+            do names.push_back(entry.cFileName);
+            while (FindNextFileA(find, &entry));
+            FindClose(find);
+        }
+#else
+        DIR* dir = opendir(directory);
+        if (dir != nullptr)
+        {
+            while (struct dirent* entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) names.push_back(name);
+            }
+            closedir(dir);
+        }
+#endif
+        std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b)
+        {
+            unsigned long long tickA = strtoull(a.c_str(), nullptr, 10), tickB = strtoull(b.c_str(), nullptr, 10);
+            return tickA != tickB ? tickA < tickB : a < b;
+        });
+        std::vector<std::string> result;
+        for (auto& name : names) result.push_back(std::string(directory) + "/" + name);
+        return result;
+    }
+
+    // Hashes txs[begin..end) and checks their signatures with one verifyGroupedByKey call, sources that
+    // sent several of them are decoded once
+    void checkTransactions(const std::vector<std::vector<uint8_t>>& txs, size_t begin, size_t end, std::vector<TxCheck>& checks)
+    {
+        uint8_t publicKeys[VERIFY_CHUNK_SIZE * 32], digests[VERIFY_CHUNK_SIZE * 32], signatures[VERIFY_CHUNK_SIZE * 64];
+        bool valid[VERIFY_CHUNK_SIZE];
+        size_t indices[VERIFY_CHUNK_SIZE];
+        unsigned int count = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& raw = txs[i];
+            TxCheck& check = checks[i];
+            memset(check.digest, 0, 32);
+            check.signatureValid = false;
+            if (raw.size() < sizeof(Transaction)) continue;
+            Transaction tx;
+            memcpy(&tx, raw.data(), sizeof(Transaction));
+            size_t signedSize = sizeof(Transaction) + tx.inputSize;
+            if (signedSize + SIGNATURE_SIZE > raw.size()) continue;
+            KangarooTwelve(raw.data(), (unsigned int)raw.size(), check.digest, 32);
+            KangarooTwelve(raw.data(), (unsigned int)signedSize, digests + 32 * count, 32);
+            memcpy(publicKeys + 32 * count, tx.sourcePublicKey, 32);
+            memcpy(signatures + 64 * count, raw.data() + signedSize, SIGNATURE_SIZE);
+            indices[count++] = i;
+        }
+        verifyGroupedByKey(publicKeys, digests, signatures, count, valid);
+        for (unsigned int j = 0; j < count; j++) checks[indices[j]].signatureValid = valid[j];
+    }
+
+    bool digestLess(const uint8_t* a, const uint8_t* b)
+    {
+        return memcmp(a, b, 32) < 0;
+    }
+}
+
+void verifyTransactions(const std::vector<std::vector<uint8_t>>& txs, int jobs, std::vector<TxCheck>& checks)
+{
+    checks.resize(txs.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t begin = next.fetch_add(VERIFY_CHUNK_SIZE); begin < txs.size(); begin = next.fetch_add(VERIFY_CHUNK_SIZE))
+        {
+            checkTransactions(txs, begin, std::min(begin + VERIFY_CHUNK_SIZE, txs.size()), checks);
+        }
+    };
+    size_t threads = std::min(size_t(std::max(jobs, 1)), (txs.size() + VERIFY_CHUNK_SIZE - 1) / VERIFY_CHUNK_SIZE);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+}
+
+void auditTick(const FetchedTick& tick, const ComputorList& computors, int jobs, TickAudit& result,
+               std::vector<TxCheck>& checks)
+{
+    const SparseTickData& td = tick.tickData;
+    result.tick = td.header.tick;
+    result.epochMatches = td.header.epoch == computors.epoch();
+    result.signatureValid = verifyTickSignature(td, computors);
+    verifyTransactions(tick.transactions, jobs, checks);
+    result.numTx = td.numTx();
+    result.txCount = int(tick.transactions.size());
+    result.badSignatures = 0;
+    std::vector<const uint8_t*> received, announced;
+    for (auto& check : checks)
+    {
+        if (!check.signatureValid) result.badSignatures++;
+        received.push_back(check.digest);
+    }
+    for (size_t offset = 0; offset < td.digests.size(); offset += 32) announced.push_back(td.digests.data() + offset);
+    std::sort(received.begin(), received.end(), digestLess);
+    std::sort(announced.begin(), announced.end(), digestLess);
+    result.missing = 0;
+    for (auto digest : announced)
+    {
+        if (!std::binary_search(received.begin(), received.end(), digest, digestLess)) result.missing++;
+    }
+    result.unexpected = 0;
+    for (auto digest : received)
+    {
+        if (!std::binary_search(announced.begin(), announced.end(), digest, digestLess)) result.unexpected++;
+    }
+}
+
+void verifyTickFiles(const char* path, const char* compFile, int jobs)
+{
+    ComputorListPtr computors = readComputorListFromFile(compFile);
+    if (!computors) return;
+    bool directory = isDirectory(path);
+    TickArchiveReader archive;
+    std::vector<std::string> files;
+    std::vector<uint32_t> ticks;
+    if (directory)
+    {
+        files = listTickFiles(path);
+    }
+    else
+    {
+        if (!archive.open(path))
+        {
+            LOG("%s is neither a directory nor a tick archive\n", path);
+            return;
+        }
+        for (auto& entry : archive.index()) ticks.push_back(entry.tick);
+    }
+    size_t count = directory ? files.size() : ticks.size();
+    if (count == 0)
+    {
+        LOG("No tick to verify in %s\n", path);
+        return;
+    }
+
+    std::vector<TickAudit> audits(count);
+    std::vector<TickFileState> states(count, TICK_FILE_UNREADABLE);
+    std::atomic<size_t> next(0);
+    auto start = std::chrono::steady_clock::now();
+    // one tick per thread at a time, each thread keeps its buffers from tick to tick
+    auto worker = [&]()
+    {
+        std::unique_ptr<FetchedTick> fetched(new FetchedTick);
+        std::vector<TxCheck> checks;
+        for (size_t i = next++; i < count; i = next++)
+        {
+            if (directory)
+            {
+                if (!readTickFile(files[i].c_str(), *fetched)) continue;
+            }
+            else
+            {
+                TickFetchResult read = archive.readTick(ticks[i], *fetched);
+                if (read == TICK_NOT_REACHED) continue;
+                if (read == TICK_EMPTY)
+                {
+                    states[i] = TICK_FILE_EMPTY;
+                    continue;
+                }
+            }
+            auditTick(*fetched, *computors, 1, audits[i], checks);
+            states[i] = TICK_FILE_AUDITED;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < jobs && t < int(count); t++) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int audited = 0, empty = 0, unreadable = 0, badTicks = 0, otherEpoch = 0;
+    long long txs = 0, badTxs = 0, missing = 0, unexpected = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string name = directory ? files[i] : "tick " + std::to_string(ticks[i]);
+        if (states[i] == TICK_FILE_EMPTY)
+        {
+            empty++;
+            continue;
+        }
+        if (states[i] == TICK_FILE_UNREADABLE)
+        {
+            LOG("%s: can not be read\n", name.c_str());
+            unreadable++;
+            continue;
+        }
+        const TickAudit& audit = audits[i];
+        audited++;
+        txs += audit.txCount;
+        badTxs += audit.badSignatures;
+        missing += audit.missing;
+        unexpected += audit.unexpected;
+        if (!audit.epochMatches) otherEpoch++;
+        if (!audit.signatureValid) badTicks++;
+        if (audit.epochMatches && audit.signatureValid && !audit.badSignatures && !audit.missing && !audit.unexpected) continue;
+        LOG("%s (tick %u):", name.c_str(), audit.tick);
+        if (!audit.epochMatches) LOG(" not from the epoch of the computor list,");
+        LOG(" tick data %s", audit.signatureValid ? "VERIFIED" : "NOT verified");
+        if (audit.badSignatures) LOG(", %d of %d transactions NOT verified", audit.badSignatures, audit.txCount);
+        if (audit.missing) LOG(", %d of %d announced transactions missing", audit.missing, audit.numTx);
+        if (audit.unexpected) LOG(", %d transactions not announced", audit.unexpected);
+        LOG("\n");
+    }
+    LOG("Verified %d ticks (%d empty, %d unreadable) and %lld transactions in %.2fs (%.0f tx/s) with %d threads\n",
+        audited, empty, unreadable, txs, seconds, seconds > 0 ? txs / seconds : 0.0, jobs);
+    LOG("Tick data NOT verified: %d, from another epoch: %d\n", badTicks, otherEpoch);
+    LOG("Transactions NOT verified: %lld, missing: %lld, not announced: %lld\n", badTxs, missing, unexpected);
+}
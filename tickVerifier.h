@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "nodeUtils.h"
+
+#define VERIFY_CHUNK_SIZE 16 // transactions a verifying thread takes at once
+
+struct TxCheck
+{
+    uint8_t digest[32];  // K12 of the whole transaction, the tx hash
+    bool signatureValid; // signed by its source
+};
+
+// Hashes and checks the signature of each raw transaction (Transaction, input, signature) with jobs threads,
+// reading them in place. checks[i] belongs to txs[i]
+void verifyTransactions(const std::vector<std::vector<uint8_t>>& txs, int jobs, std::vector<TxCheck>& checks);
+
+struct TickAudit
+{
+    uint32_t tick;
+    bool epochMatches;  // the tick is from the epoch of the computor list
+    bool signatureValid; // the tick data is signed by the computor of its index
+    int numTx;          // transactions announced by the tick data
+    int txCount;        // transactions present
+    int badSignatures;  // present transactions not signed by their source
+    int missing;        // announced transactions that are not present
+    int unexpected;     // present transactions the tick data does not announce
+};
+
+// Checks tick data signature and every transaction of tick, with jobs threads for the transactions
+void auditTick(const FetchedTick& tick, const ComputorList& computors, int jobs, TickAudit& result,
+               std::vector<TxCheck>& checks);
+
+// Verifies every tick of a directory of -gettickdata files (*.bin) or of a tick archive against the computor list
+// of compFile, jobs ticks at once. Prints the ticks that fail and a summary
+void verifyTickFiles(const char* path, const char* compFile, int jobs);
@@ -0,0 +1,194 @@
+#include <cstring>
+#include <string>
+#include "txIndex.h"
+#include "K12AndKeyUtil.h"
+#include "keyUtils.h"
+#include "walletUtils.h"
+#include "logger.h"
+
+static uint64_t digestKey(const uint8_t* digest)
+{
+    uint64_t key;
+    memcpy(&key, digest, sizeof(key));
+    return key;
+}
+
+static const TxIndexHeader* validHeader(const uint8_t* data, uint64_t size, const TickArchiveReader& archive)
+{
+    auto header = (const TxIndexHeader*)data;
+    if (data == nullptr || size < sizeof(TxIndexHeader) || memcmp(header->magic, TX_INDEX_MAGIC, 4) != 0
+        || header->version != TX_INDEX_VERSION)
+    {
+        return nullptr;
+    }
+    // find() masks keys with slotCount - 1, anything but a power of two covering exactly the rest of the file
+    // would read outside of it
+    uint64_t slotCount = header->slotCount;
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || slotCount != (size - sizeof(TxIndexHeader)) / sizeof(TxIndexSlot)
+        || size != sizeof(TxIndexHeader) + slotCount * sizeof(TxIndexSlot))
+    {
+        return nullptr;
+    }
+    if (header->archiveRecordsEnd != archive.recordsEnd() || header->archiveTickCount != archive.index().size()) return nullptr;
+    return header;
+}
+
+// Hashes every archived transaction once and lays the table out in memory
+static std::vector<uint8_t> buildTxIndex(const TickArchiveReader& archive)
+{
+    std::vector<TxIndexSlot> entries;
+    const uint8_t* data = archive.data();
+    for (auto& indexEntry : archive.index())
+    {
+        auto record = archive.findRecord(indexEntry.tick);
+        if (record == nullptr || record->empty) continue;
+        const uint8_t* ptr = tickRecordTransactions(record);
+        const uint8_t* end = (const uint8_t*)record + record->size;
+        for (int i = 0; i < record->txCount && ptr + sizeof(Transaction) <= end; i++)
+        {
+            Transaction tx;
+            memcpy(&tx, ptr, sizeof(Transaction));
+            size_t txSize = sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE;
+            if (ptr + txSize > end) break;
+            uint8_t digest[32];
+            KangarooTwelve(ptr, txSize, digest, 32);
+            TxIndexSlot slot;
+            slot.key = digestKey(digest);
+            slot.offset = ptr - data;
+            slot.tick = record->tick;
+            entries.push_back(slot);
+            ptr += txSize;
+        }
+    }
+
+    uint64_t slotCount = 16;
+    while (slotCount < entries.size() * 2) slotCount <<= 1;
+    std::vector<uint8_t> result(sizeof(TxIndexHeader) + slotCount * sizeof(TxIndexSlot), 0);
+    auto header = (TxIndexHeader*)result.data();
+    memcpy(header->magic, TX_INDEX_MAGIC, 4);
+    header->version = TX_INDEX_VERSION;
+    header->archiveRecordsEnd = archive.recordsEnd();
+    header->archiveTickCount = uint32_t(archive.index().size());
+    header->txCount = uint32_t(entries.size());
+    header->slotCount = slotCount;
+    auto slots = (TxIndexSlot*)(header + 1);
+    for (auto& entry : entries)
+    {
+        uint64_t i = entry.key & (slotCount - 1);
+        while (slots[i].offset != 0) i = (i + 1) & (slotCount - 1);
+        slots[i] = entry;
+    }
+    return result;
+}
+
+bool TxIndex::open(const TickArchiveReader& archive, const char* archiveFile, bool write)
+{
+    mFile.close();
+    mMemory.clear();
+    std::string indexFile = std::string(archiveFile) + TX_INDEX_EXTENSION;
+    if (mFile.open(indexFile.c_str()) && validHeader(mFile.data(), mFile.size(), archive)) return true;
+    mFile.close();
+
+    std::vector<uint8_t> built = buildTxIndex(archive);
+    if (!write)
+    {
+        mMemory.swap(built);
+        return true;
+    }
+    FILE* f = fopen((indexFile + ".part").c_str(), "wb");
+    bool written = f != nullptr && fwrite(built.data(), 1, built.size(), f) == built.size();
+    if (f != nullptr) fclose(f);
+    if (written)
+    {
+        remove(indexFile.c_str());
+        written = rename((indexFile + ".part").c_str(), indexFile.c_str()) == 0;
+    }
+    if (written && mFile.open(indexFile.c_str()) && validHeader(mFile.data(), mFile.size(), archive)) return true;
+    mFile.close();
+    LOG("Failed to write %s, the index is kept in memory\n", indexFile.c_str());
+    mMemory.swap(built);
+    return true;
+}
+
+const uint8_t* TxIndex::find(const TickArchiveReader& archive, const uint8_t* digest, uint32_t& tick) const
+{
+    const uint8_t* data = mMemory.empty() ? mFile.data() : mMemory.data();
+    if (data == nullptr) return nullptr;
+    auto header = (const TxIndexHeader*)data;
+    auto slots = (const TxIndexSlot*)(header + 1);
+    uint64_t key = digestKey(digest);
+    uint64_t probes = 0;
+    for (uint64_t i = key & (header->slotCount - 1); slots[i].offset != 0 && probes < header->slotCount;
+         i = (i + 1) & (header->slotCount - 1), probes++)
+    {
+        if (slots[i].key != key || slots[i].offset + sizeof(Transaction) > archive.recordsEnd()) continue;
+        const uint8_t* tx = archive.data() + slots[i].offset;
+        Transaction txHeader;
+        memcpy(&txHeader, tx, sizeof(Transaction));
+        size_t txSize = sizeof(Transaction) + txHeader.inputSize + SIGNATURE_SIZE;
+        if (slots[i].offset + txSize > archive.recordsEnd()) continue;
+        uint8_t txDigest[32];
+        KangarooTwelve(tx, txSize, txDigest, 32);
+        if (memcmp(txDigest, digest, 32) != 0) continue;
+        tick = slots[i].tick;
+        return tx;
+    }
+    return nullptr;
+}
+
+bool isTickArchive(const char* fileName)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (f == nullptr) return false;
+    char magic[4] = {0};
+    bool result = fread(magic, 1, 4, f) == 4 && memcmp(magic, TICK_ARCHIVE_MAGIC, 4) == 0;
+    fclose(f);
+    return result;
+}
+
+bool checkTxOnArchives(const char* txHash, const std::vector<std::string>& archiveFiles)
+{
+    uint8_t digest[32];
+    if (!getDigestFromTxHash(txHash, digest))
+    {
+        LOG("Invalid tx hash %s\n", txHash);
+        return false;
+    }
+    for (auto& archiveFile : archiveFiles)
+    {
+        TickArchiveReader archive;
+        TxIndex index;
+        if (!archive.open(archiveFile.c_str()))
+        {
+            LOG("%s is not a tick archive\n", archiveFile.c_str());
+            continue;
+        }
+        if (!index.open(archive, archiveFile.c_str(), false)) continue;
+        uint32_t tick = 0;
+        const uint8_t* raw = index.find(archive, digest, tick);
+        if (raw == nullptr) continue;
+        Transaction tx;
+        memcpy(&tx, raw, sizeof(Transaction));
+        LOG("Found tx %s on file %s (tick %u)\n", txHash, archiveFile.c_str(), tick);
+        printReceipt(tx, txHash, raw + sizeof(Transaction));
+        return true;
+    }
+    if (archiveFiles.size() == 1) LOG("Can NOT find tx %s on file %s\n", txHash, archiveFiles[0].c_str());
+    else LOG("Can NOT find tx %s on %d files\n", txHash, int(archiveFiles.size()));
+    return false;
+}
+
+void buildTxIndexes(const std::vector<std::string>& archiveFiles)
+{
+    for (auto& archiveFile : archiveFiles)
+    {
+        TickArchiveReader archive;
+        TxIndex index;
+        if (!archive.open(archiveFile.c_str()))
+        {
+            LOG("%s is not a tick archive\n", archiveFile.c_str());
+            continue;
+        }
+        if (index.open(archive, archiveFile.c_str(), true) && index.saved()) LOG("%s%s is up to date\n", archiveFile.c_str(), TX_INDEX_EXTENSION);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tickArchive.h"
+
+// Transaction index of a tick archive, kept next to it as <ARCHIVE_FILE>.txidx:
+// TxIndexHeader, then an open addressing hash table of slotCount TxIndexSlot keyed by the first
+// 8 bytes of the transaction digest (the tx hash decoded), with linear probing and offset 0 for a free slot.
+// A hit is confirmed by hashing the one transaction it points to.
+#define TX_INDEX_MAGIC "QTXI"
+#define TX_INDEX_VERSION 1
+#define TX_INDEX_EXTENSION ".txidx"
+
+#pragma pack(push, 1)
+struct TxIndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t archiveRecordsEnd; // the index is rebuilt when the archive has grown since
+    uint32_t archiveTickCount;
+    uint32_t txCount;
+    uint64_t slotCount;         // power of two
+};
+
+struct TxIndexSlot
+{
+    uint64_t key;
+    uint64_t offset; // of the transaction in the archive
+    uint32_t tick;
+};
+#pragma pack(pop)
+
+class TxIndex
+{
+public:
+    // Maps <archiveFile>.txidx. If it is missing or out of date the index is built, and with write also saved
+    // there (kept in memory when that fails): looking a transaction up leaves the directory of the archive alone.
+    bool open(const TickArchiveReader& archive, const char* archiveFile, bool write);
+    // The raw transaction (Transaction, input, signature) with this digest inside the archive, nullptr if there is none
+    const uint8_t* find(const TickArchiveReader& archive, const uint8_t* digest, uint32_t& tick) const;
+    // True if the index was read from, or saved to, <archiveFile>.txidx
+    bool saved() const { return mFile.data() != nullptr; }
+
+private:
+    MappedFile mFile;
+    std::vector<uint8_t> mMemory; // the index when it could not be written
+};
+
+// Looks for a transaction in tick archives, through their index. Prints the receipt when found
+bool checkTxOnArchives(const char* txHash, const std::vector<std::string>& archiveFiles);
+// Writes the .txidx of each archive that has none or an out of date one
+void buildTxIndexes(const std::vector<std::string>& archiveFiles);
+// True if fileName is a tick archive rather than a -gettickdata file
+bool isTickArchive(const char* fileName);
@@ -2,6 +2,8 @@
 #include <thread>
 #include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <string>
 #include "utils.h"
 #include "nodeUtils.h"
 #include "keyUtils.h"
@@ -18,9 +20,7 @@ void printWalletInfo(const char* seed)
 	char privateKeyQubicFormat[128] = {0};
 	char publicKeyQubicFormat[128] = {0};
     char publicIdentity[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, publicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, publicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(publicKey, publicIdentity, isLowerCase);
 
@@ -31,14 +31,10 @@ void printWalletInfo(const char* seed)
     LOG("Public key: %s\n", publicKeyQubicFormat);
     LOG("Identity: %s\n", publicIdentity);
 }
-RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t* publicKey)
+RespondedEntity getBalance(QCPtr qc, const uint8_t* publicKey)
 {
     RespondedEntity result;
     memset(&result, 0, sizeof(RespondedEntity));
-    std::vector<uint8_t> buffer;
-    buffer.resize(0);
-    uint8_t tmp[1024] = {0};
-    auto qc = make_qc(nodeIp, nodePort);
     struct {
         RequestResponseHeader header;
         RequestedEntity req;
@@ -48,15 +44,10 @@ RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t
     packet.header.setType(REQUEST_ENTITY);
     memcpy(packet.req.publicKey, publicKey, 32);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    int recvByte = qc->receiveData(tmp, 1024);
-    while (recvByte > 0)
-    {
-        buffer.resize(recvByte + buffer.size());
-        memcpy(buffer.data() + buffer.size() - recvByte, tmp, recvByte);
-        recvByte = qc->receiveData(tmp, 1024);
-    }
+    std::vector<uint8_t> buffer;
+    qc->receiveDataUntil(buffer, {RESPOND_ENTITY});
     uint8_t* data = buffer.data();
-    recvByte = buffer.size();
+    int recvByte = buffer.size();
     int ptr = 0;
     while (ptr < recvByte)
     {
@@ -71,6 +62,12 @@ RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t
     return result;
 }
 
+RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t* publicKey)
+{
+    auto qc = make_qc(nodeIp, nodePort);
+    return getBalance(qc, publicKey);
+}
+
 void getSpectrumDigest(RespondedEntity& respondedEntity, uint8_t* spectrumDigest)
 {
     // Check if the size of entity is good
@@ -98,11 +95,8 @@ void getSpectrumDigest(RespondedEntity& respondedEntity, uint8_t* spectrumDigest
         spectrumDigest);
 }
 
-void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort)
+void printEntity(const char* publicIdentity, RespondedEntity& entity)
 {
-    uint8_t publicKey[32] = {0};
-    getPublicKeyFromIdentity(publicIdentity, publicKey);
-    auto entity = getBalance(nodeIp, nodePort, publicKey);
     LOG("Identity: %s\n", publicIdentity);
     LOG("Balance: %lld\n", entity.entity.incomingAmount - entity.entity.outgoingAmount);
     LOG("Incoming Amount: %lld\n", entity.entity.incomingAmount);
@@ -115,12 +109,100 @@ void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort)
     // Get the spectrum digest from entity
     uint8_t spectumDigest[32] = {0};
     getSpectrumDigest(entity, spectumDigest);
-    char hex[64];
+    char hex[65];
     LOG("Tick: %u\n", entity.tick);
     byteToHex(spectumDigest, hex, 32);
     LOG("Spectum Digest: %s\n", hex);
 }
 
+void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort)
+{
+    uint8_t publicKey[32] = {0};
+    getPublicKeyFromIdentity(publicIdentity, publicKey);
+    auto entity = getBalance(nodeIp, nodePort, publicKey);
+    printEntity(publicIdentity, entity);
+}
+
+std::vector<RespondedEntity> getBalances(const char* nodeIp, const int nodePort, const uint8_t (*publicKeys)[32], size_t count)
+{
+    std::vector<RespondedEntity> results(count);
+    if (count == 0) return results;
+    auto qc = make_qc(nodeIp, nodePort);
+    struct {
+        RequestResponseHeader header;
+        RequestedEntity req;
+    } packet;
+    std::vector<PipelineRequest> requests(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        packet.header.setSize(sizeof(packet));
+        packet.header.randomizeDejavu();
+        packet.header.setType(REQUEST_ENTITY);
+        memcpy(packet.req.publicKey, publicKeys[i], 32);
+        requests[i].packet.assign((uint8_t*)&packet, (uint8_t*)&packet + sizeof(packet));
+        requests[i].responseType = RESPOND_ENTITY;
+        requests[i].multiPacket = false;
+    }
+    qc->pipeline(requests);
+    for (size_t i = 0; i < count; i++)
+    {
+        memset(&results[i], 0, sizeof(RespondedEntity));
+        if (requests[i].completed && requests[i].response.size() >= sizeof(RespondedEntity))
+        {
+            memcpy(&results[i], requests[i].response.data(), sizeof(RespondedEntity));
+        }
+    }
+    return results;
+}
+
+void printBalances(const char* identityListFile, const char* nodeIp, int nodePort)
+{
+    std::vector<std::string> identities;
+    std::ifstream infile(identityListFile);
+    if (!infile)
+    {
+        LOG("Failed to open %s\n", identityListFile);
+        return;
+    }
+    std::string line;
+    int lineNumber = 0, malformed = 0;
+    while (std::getline(infile, line))
+    {
+        lineNumber++;
+        // trailing whitespace and CR of files written on Windows do not matter, blank lines are skipped
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty()) continue;
+        if (line.size() != 60 || !checkSumIdentity(&line[0]))
+        {
+            LOG("Line %d: %s is not a valid identity, skipped\n", lineNumber, line.c_str());
+            malformed++;
+            continue;
+        }
+        identities.push_back(line);
+    }
+    if (malformed) LOG("%d malformed lines skipped\n", malformed);
+    std::vector<uint8_t> publicKeys(identities.size() * 32);
+    for (size_t i = 0; i < identities.size(); i++)
+    {
+        getPublicKeyFromIdentity(identities[i].data(), publicKeys.data() + i * 32);
+    }
+    auto entities = getBalances(nodeIp, nodePort, (const uint8_t (*)[32])publicKeys.data(), identities.size());
+    int missing = 0;
+    for (size_t i = 0; i < identities.size(); i++)
+    {
+        // a valid answer always carries the tick it was taken at
+        if (entities[i].tick == 0)
+        {
+            LOG("%s no response\n", identities[i].c_str());
+            missing++;
+            continue;
+        }
+        LOG("%s %lld %u\n", identities[i].c_str(),
+            entities[i].entity.incomingAmount - entities[i].entity.outgoingAmount, entities[i].tick);
+    }
+    if (missing) LOG("%d/%d identities did not get a response\n", missing, int(identities.size()));
+}
+
 void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t* extraData = nullptr, int moneyFlew = -1)
 {
     char sourceIdentity[128] = {0};
@@ -184,9 +266,7 @@ void makeStandardTransactionInTick(const char* nodeIp, int nodePort, const char*
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     getPublicKeyFromIdentity(targetIdentity, destPublicKey);
@@ -227,7 +307,7 @@ void makeStandardTransactionInTick(const char* nodeIp, int nodePort, const char*
             Q_SLEEP(1000);
             currentTick = getTickNumberFromNode(qc);
         }
-        checkTxOnTick(nodeIp, nodePort, txHash, packet.transaction.tick);
+        checkTxOnTick(qc, txHash, packet.transaction.tick);
     } else {
         LOG("run ./qubic-cli [...] -checktxontick %u %s\n", txTick, txHash);
         LOG("to check your tx confirmation status\n");
@@ -239,9 +319,12 @@ void makeStandardTransaction(const char* nodeIp, int nodePort, const char* seed,
                              const char* targetIdentity, const uint64_t amount, uint32_t scheduledTickOffset,
                              int waitUntilFinish)
 {
-    auto qc = make_qc(nodeIp, nodePort);
-    uint32_t currentTick = getTickNumberFromNode(qc);
-    uint32_t txTick = currentTick + scheduledTickOffset;
+    uint32_t txTick;
+    {
+        // released before the call below so that it picks up this same session from the pool
+        auto qc = make_qc(nodeIp, nodePort);
+        txTick = getTickNumberFromNode(qc) + scheduledTickOffset;
+    }
     makeStandardTransactionInTick(nodeIp, nodePort, seed, targetIdentity, amount, txTick, waitUntilFinish); 
 }
 
@@ -264,9 +347,7 @@ void makeCustomTransaction(const char* nodeIp, int nodePort,
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     getPublicKeyFromIdentity(targetIdentity, destPublicKey);
@@ -325,9 +406,7 @@ void makeIPOBid(const char* nodeIp, int nodePort,
     uint8_t signature[64] = {0};
     char publicIdentity[128] = {0};
     char txHash[128] = {0};
-    getSubseedFromSeed((uint8_t*)seed, subseed);
-    getPrivateKeyFromSubSeed(subseed, privateKey);
-    getPublicKeyFromPrivateKey(privateKey, sourcePublicKey);
+    getKeysFromSeed((uint8_t*)seed, subseed, privateKey, sourcePublicKey);
     const bool isLowerCase = false;
     getIdentityFromPublicKey(sourcePublicKey, publicIdentity, isLowerCase);
     // Contracts are identified by their index stored in the first 64 bits of the id, all
@@ -388,7 +467,7 @@ RespondContractIPO _getIPOStatus(const char* nodeIp, int nodePort, uint32_t cont
     packet.req.contractIndex = contractIndex;
     qc->sendData((uint8_t *) &packet, packet.header.size());
     std::vector<uint8_t> buffer;
-    qc->receiveDataAll(buffer);
+    qc->receiveDataUntil(buffer, {RESPOND_CONTRACT_IPO});
     uint8_t* data = buffer.data();
     int recvByte = buffer.size();
     int ptr = 0;
@@ -1,6 +1,14 @@
 #pragma once
+#include <vector>
+#include "structs.h"
+#include "connection.h"
 void printWalletInfo(const char* seed);
 void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort);
+RespondedEntity getBalance(QCPtr qc, const uint8_t* publicKey);
+void printEntity(const char* publicIdentity, RespondedEntity& entity);
+// Queries the entities of all public keys pipelined on one connection, entries without answer are zeroed
+std::vector<RespondedEntity> getBalances(const char* nodeIp, const int nodePort, const uint8_t (*publicKeys)[32], size_t count);
+void printBalances(const char* identityListFile, const char* nodeIp, int nodePort);
 void makeStandardTransaction(const char* nodeIp, int nodePort, const char* seed,
                              const char* targetIdentity, const uint64_t amount, uint32_t scheduledTickOffset,
                              int waitUntilFinish);